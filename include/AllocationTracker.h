@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Build with -DORDERBOOK_ALLOC_TRACKING=ON to replace the global operator new/delete with
+// counting versions. Every allocation is charged to the pipeline stage the allocating thread is
+// in, and allocations inside a depth message are also tallied per message. With tracking off the
+// scopes compile to nothing and snapshot() reports zeros.
+
+enum class AllocationStage : uint8_t
+{
+    OTHER,    // Outside any tracked stage
+    PARSE,    // Frame to DepthEvent
+    SEQUENCE, // Arbitration, buffering and U/u validation
+    APPLY,    // Level updates, depth bound, views and journal
+    PUBLISH,  // Subscriber changes, analytics and multi-book rows
+    COUNT
+};
+
+const char *allocationStageName(AllocationStage stage);
+
+struct AllocationStageStats
+{
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+struct AllocationStats
+{
+    std::array<AllocationStageStats, static_cast<size_t>(AllocationStage::COUNT)> stages{};
+    uint64_t messages = 0;                 // Depth messages handled
+    uint64_t messagesWithAllocations = 0;  // Messages that allocated at least once
+    uint64_t maxAllocationsPerMessage = 0; // Worst single message
+    uint64_t frees = 0;
+
+    const AllocationStageStats &operator[](AllocationStage stage) const
+    {
+        return stages[static_cast<size_t>(stage)];
+    }
+};
+
+class AllocationTracker
+{
+  public:
+    static constexpr bool ENABLED =
+#ifdef ORDERBOOK_ALLOC_TRACKING
+        true;
+#else
+        false;
+#endif
+
+    static AllocationStats snapshot();
+    static void reset();
+
+    // Called by the replaced operator new
+    static void record(size_t bytes);
+    static void recordFree();
+};
+
+// Charges allocations on this thread to a stage until destroyed; scopes nest
+class AllocationStageScope
+{
+  private:
+    AllocationStage previous;
+
+  public:
+    explicit AllocationStageScope(AllocationStage stage);
+    ~AllocationStageScope();
+
+    AllocationStageScope(const AllocationStageScope &) = delete;
+    AllocationStageScope &operator=(const AllocationStageScope &) = delete;
+};
+
+// Marks one depth message on this thread, from frame to applied book
+class AllocationMessageScope
+{
+  private:
+    uint64_t startAllocations;
+    bool outermost;
+
+  public:
+    AllocationMessageScope();
+    ~AllocationMessageScope();
+
+    AllocationMessageScope(const AllocationMessageScope &) = delete;
+    AllocationMessageScope &operator=(const AllocationMessageScope &) = delete;
+};
+
+#ifdef ORDERBOOK_ALLOC_TRACKING
+#define ORDERBOOK_ALLOC_CONCAT_(a, b) a##b
+#define ORDERBOOK_ALLOC_SCOPE_NAME_(line) ORDERBOOK_ALLOC_CONCAT_(allocationScope_, line)
+#define ORDERBOOK_ALLOC_STAGE(stage) AllocationStageScope ORDERBOOK_ALLOC_SCOPE_NAME_(__LINE__)(AllocationStage::stage)
+#define ORDERBOOK_ALLOC_MESSAGE() AllocationMessageScope ORDERBOOK_ALLOC_SCOPE_NAME_(__LINE__)
+#else
+#define ORDERBOOK_ALLOC_STAGE(stage) ((void)0)
+#define ORDERBOOK_ALLOC_MESSAGE() ((void)0)
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "OrderBookData.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Cross-symbol metrics from one compute() pass, one entry per symbol slot.
+// Metrics of a symbol without both sides are NaN and it is left out of the z-scores.
+struct AnalyticsSnapshot
+{
+    size_t size = 0;
+
+    // Top of book as read from the table; NaN for an empty side
+    std::vector<double> bidPrice;
+    std::vector<double> bidQuantity;
+    std::vector<double> askPrice;
+    std::vector<double> askQuantity;
+    std::vector<long long> updateId;
+
+    std::vector<double> mid;
+    std::vector<double> spread;
+    std::vector<double> spreadBps;
+    std::vector<double> microprice; // Size-weighted toward the thinner side
+    std::vector<double> imbalance;  // (bidQty - askQty) / (bidQty + askQty), in [-1, 1]
+
+    // Cross-sectional signals across every symbol with a two-sided book
+    std::vector<double> imbalanceZ;
+    std::vector<double> spreadBpsZ;
+    std::vector<uint32_t> imbalanceRank; // Slots ordered from most bid-heavy to most ask-heavy
+
+    std::vector<double> scratch; // Reused by the reductions
+};
+
+// Structure-of-arrays table of every symbol's top of book. Each synchronizer writes its own row
+// on a BBO change, under a per-row sequence lock, so writers never wait and readers retry a row
+// that changed under them. compute() copies the columns and runs the metric kernels as flat
+// loops over contiguous doubles, which the compiler vectorizes.
+class AnalyticsTable
+{
+  private:
+    size_t capacity;
+    std::atomic<size_t> rows{0};
+
+    // Columns, sized to capacity up front so writers never see them move
+    std::unique_ptr<std::atomic<uint32_t>[]> sequences;
+    std::unique_ptr<double[]> bidPrices;
+    std::unique_ptr<double[]> bidQuantities;
+    std::unique_ptr<double[]> askPrices;
+    std::unique_ptr<double[]> askQuantities;
+    std::unique_ptr<long long[]> updateIds;
+
+    std::vector<std::string> symbols;
+    mutable std::mutex symbolsMutex;
+
+    static void computeMetrics(AnalyticsSnapshot &out);
+    static void computeSignals(AnalyticsSnapshot &out);
+
+  public:
+    static constexpr size_t DEFAULT_CAPACITY = 1024;
+
+    explicit AnalyticsTable(size_t maxSymbols = DEFAULT_CAPACITY);
+
+    // Returns the symbol's slot; throws once the table is full
+    size_t addSymbol(const std::string &symbol);
+
+    // Single writer per slot
+    void update(size_t slot, const TopOfBook &top, long long updateId);
+
+    // Any thread; reuses the snapshot's buffers
+    void compute(AnalyticsSnapshot &out) const;
+
+    size_t size() const;
+    std::string getSymbol(size_t slot) const;
+};
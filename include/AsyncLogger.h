@@ -0,0 +1,181 @@
+#pragma once
+
+#include "SpscRing.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+enum class LogLevel : uint8_t
+{
+    DEBUG,
+    INFO,
+    WARN,
+    ERROR
+};
+
+// One argument of a log record; text is copied into the record's own buffer
+struct LogArg
+{
+    enum class Type : uint8_t
+    {
+        INT,
+        DOUBLE,
+        TEXT
+    };
+
+    Type type = Type::INT;
+    union
+    {
+        int64_t integer;
+        double real;
+        struct
+        {
+            uint16_t offset;
+            uint16_t length;
+        } text;
+    };
+};
+
+// Fixed-size binary record. The format is a string literal with {} placeholders and is only
+// read by the writer thread, which also keys rate limiting on its address.
+struct LogRecord
+{
+    static constexpr size_t MAX_ARGS = 6;
+    static constexpr size_t TEXT_CAPACITY = 128;
+
+    int64_t timestampNs = 0; // System clock
+    const char *format = nullptr;
+    LogLevel level = LogLevel::INFO;
+    uint8_t argCount = 0;
+    uint16_t textUsed = 0;
+    std::array<LogArg, MAX_ARGS> args;
+    std::array<char, TEXT_CAPACITY> text;
+};
+
+// Asynchronous logger. Each thread pushes records into its own wait-free ring, so logging never
+// takes a lock or makes a syscall on the caller's thread. A writer thread formats the records
+// and appends them to the log file. A call site that logs more than MAX_PER_SITE_PER_SECOND
+// times a second is suppressed, and a summary line reports the count.
+class AsyncLogger
+{
+  private:
+    struct ThreadBuffer
+    {
+        SpscRing<LogRecord> ring{THREAD_RING_CAPACITY};
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    struct SiteWindow
+    {
+        int64_t windowStartNs = 0;
+        uint32_t written = 0;
+        uint32_t suppressed = 0;
+        LogLevel level = LogLevel::INFO;
+    };
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::mutex buffersMutex; // Thread registration only
+
+    std::ofstream file;
+    std::thread writer;
+    std::atomic<bool> running{false};
+    std::atomic<LogLevel> minimumLevel{LogLevel::INFO};
+
+    // Writer thread state
+    std::unordered_map<const char *, SiteWindow> sites;
+    std::string line;
+    uint64_t reportedDrops = 0;
+
+    // Configuration
+    static constexpr size_t THREAD_RING_CAPACITY = 1024;
+    static constexpr uint32_t MAX_PER_SITE_PER_SECOND = 20;
+    static constexpr int WRITER_INTERVAL_MS = 20;
+    static constexpr const char *DEFAULT_LOG_FILE = "orderbook.log";
+
+    AsyncLogger();
+    ~AsyncLogger();
+    AsyncLogger(const AsyncLogger &) = delete;
+    AsyncLogger &operator=(const AsyncLogger &) = delete;
+
+    ThreadBuffer &threadBuffer();
+    void writerLoop();
+    size_t drain();
+    void write(const LogRecord &record);
+    void flushSuppressed(int64_t nowNs, bool all);
+    void formatRecord(const LogRecord &record);
+
+    static void pack(LogRecord &record, LogArg &arg, std::string_view text);
+
+    template <typename T> static void pack(LogRecord &record, LogArg &arg, const T &value)
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            arg.type = LogArg::Type::DOUBLE;
+            arg.real = value;
+        }
+        else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>)
+        {
+            arg.type = LogArg::Type::INT;
+            arg.integer = static_cast<int64_t>(value);
+        }
+        else
+        {
+            pack(record, arg, std::string_view(value));
+        }
+    }
+
+  public:
+    static AsyncLogger &instance();
+
+    // Opens the file (ORDERBOOK_LOG_FILE, default orderbook.log) and starts the writer thread
+    void start();
+    // Drains what is queued and stops the writer
+    void stop();
+
+    void setMinimumLevel(LogLevel level);
+    bool isEnabled(LogLevel level) const
+    {
+        return level >= minimumLevel.load(std::memory_order_relaxed);
+    }
+
+    template <typename... Args> void log(LogLevel level, const char *format, const Args &...args)
+    {
+        static_assert(sizeof...(Args) <= LogRecord::MAX_ARGS, "too many log arguments");
+        if (!isEnabled(level))
+        {
+            return;
+        }
+
+        LogRecord record;
+        record.timestampNs = now();
+        record.format = format;
+        record.level = level;
+        record.argCount = sizeof...(Args);
+        size_t index = 0;
+        (pack(record, record.args[index++], args), ...);
+
+        ThreadBuffer &buffer = threadBuffer();
+        if (!buffer.ring.tryPush(record))
+        {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static int64_t now();
+};
+
+#define LOG_DEBUG(...) AsyncLogger::instance().log(LogLevel::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) AsyncLogger::instance().log(LogLevel::INFO, __VA_ARGS__)
+#define LOG_WARN(...) AsyncLogger::instance().log(LogLevel::WARN, __VA_ARGS__)
+#define LOG_ERROR(...) AsyncLogger::instance().log(LogLevel::ERROR, __VA_ARGS__)
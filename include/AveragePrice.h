@@ -1,5 +1,6 @@
 #pragma once
 
+#include "ProfiledMutex.h"
 #include "utils.h"
 #include <functional>
 #include <mutex>
@@ -12,7 +13,7 @@ class AveragePrice
     double prevPrice;
     PriceChange priceChange;
 
-    std::mutex avgPriceMutex;
+    ProfiledMutex avgPriceMutex{"AveragePrice::avgPriceMutex"};
     std::function<void()> updateCallback;
 
   public:
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "BookJournal.h"
+#include "OrderBookData.h"
+#include <cstdint>
+#include <map>
+#include <vector>
+
+enum class SimSide : uint8_t
+{
+    BUY,
+    SELL
+};
+
+enum class SimOrderType : uint8_t
+{
+    LIMIT, // Rests at its price; a crossing limit takes liquidity up to its price and cancels the rest
+    MARKET // Walks the opposite side at submission
+};
+
+// An order to inject into the replay once it reaches timestampNs
+struct SimOrderRequest
+{
+    int64_t timestampNs = 0;
+    SimSide side = SimSide::BUY;
+    SimOrderType type = SimOrderType::LIMIT;
+    double price = 0.0; // LIMIT only; 0 joins the best price on the order's side
+    double quantity = 0.0;
+};
+
+struct SimOrder
+{
+    int64_t submittedNs = 0;
+    int64_t lastFillNs = 0;
+    double price = 0.0;
+    double quantity = 0.0;
+    double filled = 0.0;
+    double fillNotional = 0.0; // Sum of fill price * quantity
+    double queueAhead = 0.0;   // Displayed quantity still ahead of us at our level
+    double arrivalMid = 0.0;   // Mid price at submission, the slippage benchmark
+    SimSide side = SimSide::BUY;
+    SimOrderType type = SimOrderType::LIMIT;
+
+    double remaining() const
+    {
+        return quantity - filled;
+    }
+};
+
+struct BacktestReport
+{
+    size_t eventsReplayed = 0;
+    size_t booksLoaded = 0; // Initial checkpoint plus every resync
+    double elapsedSeconds = 0.0;
+    double eventsPerSecond = 0.0;
+
+    size_t ordersSubmitted = 0;
+    size_t ordersFilled = 0;
+    size_t ordersPartiallyFilled = 0;
+    size_t ordersUnfilled = 0;
+    double filledQuantity = 0.0;
+
+    // Signed against the arrival mid: positive is a cost, negative an improvement
+    double marketSlippageBps = 0.0;
+    double limitSlippageBps = 0.0;
+    double avgTimeToFillMs = 0.0; // Passive orders, submission to last fill
+};
+
+// Replays a delta journal through OrderBookData and simulates orders against it.
+// Resting orders sit in per-level FIFO queues of order indices. Depth data carries no trades,
+// so a level's decrease first consumes the quantity queued ahead of an order and then fills it.
+// An opposite best price at or through the order's price makes it take the crossing levels at
+// their own prices, and whatever they cannot fill is cancelled.
+class BacktestEngine
+{
+  private:
+    OrderBookData book;
+
+    std::vector<SimOrderRequest> requests;
+    std::vector<SimOrder> orders;
+
+    // Resting limit orders by price, best first; each level is a FIFO of indices into orders
+    std::map<double, std::vector<uint32_t>, std::greater<double>> restingBuys;
+    std::map<double, std::vector<uint32_t>> restingSells;
+
+    double getMid() const;
+    void submit(const SimOrderRequest &request);
+    void takeLiquidity(SimOrder &order, double limitPrice, int64_t now);
+    void fill(SimOrder &order, double quantity, double price, int64_t now);
+
+    void applyDelta(const JournalDelta &delta);
+    template <typename Levels>
+    void consumeQueue(Levels &levels, double price, double decrease, int64_t now);
+    void fillCrossedOrders(int64_t now);
+
+    BacktestReport summarize() const;
+
+  public:
+    BacktestEngine() = default;
+
+    void addOrder(const SimOrderRequest &request);
+
+    // Replays every delta after the journal's first checkpoint
+    BacktestReport run(const BookJournalReader &reader);
+
+    const std::vector<SimOrder> &getOrders() const;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "utils.h"
+#include <functional>
 #include <future>
 #include <string>
 
@@ -15,11 +16,25 @@ struct DepthSnapshot
 class BinanceAPI
 {
   public:
+    using SnapshotCompletion = std::function<void(DepthSnapshot &&)>;
+    using TickSizeCompletion = std::function<void(double &&)>;
+
+    // Completion runs on the HTTP engine thread
+    static void fetchDepthSnapshot(const std::string &symbol, int limit, SnapshotCompletion completion);
     static std::future<DepthSnapshot> getDepthSnapshotAsync(const std::string &symbol, int limit = 5000);
-    static DepthSnapshot getDepthSnapshot(const std::string &symbol, int limit = 5000);
+    static DepthSnapshot getDepthSnapshot(const std::string &symbol, int limit = 5000); // Not from a completion
+
+    // PRICE_FILTER tickSize from exchangeInfo, or 0 on failure; completion runs on the HTTP engine thread
+    static void fetchTickSize(const std::string &symbol, TickSizeCompletion completion);
+
+    // Request weight Binance charges for a depth snapshot of this size
+    static int getDepthRequestWeight(int limit);
 
   private:
+    static constexpr int EXCHANGE_INFO_WEIGHT = 20;
+
     static DepthSnapshot parseSnapshotResponse(const std::string &response);
-    static std::string makeHttpRequest(const std::string &url);
+    static double parseTickSize(const std::string &response);
     static std::string buildSnapshotUrl(const std::string &symbol, int limit);
+    static std::string upperCase(const std::string &symbol);
 };
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "BinanceAPI.h"
+#include "LevelSubscription.h"
+#include "OrderBookData.h"
+#include <cstddef>
+#include <vector>
+
+// A level update applied while an audit was open, as its depth event carried it
+struct AuditDelta
+{
+    long long updateId = 0; // u of the event
+    double price = 0.0;
+    double quantity = 0.0;
+    BookSide side = BookSide::BID;
+};
+
+// Outcome of comparing the live book with a REST snapshot rolled to the same update id
+struct BookAuditResult
+{
+    long long updateId = 0;      // Both books as of this u
+    size_t comparedLevels = 0;   // Positions compared, both sides
+    size_t mismatchedLevels = 0; // Positions where the price or quantity differ
+    BookSide firstMismatchSide = BookSide::BID;
+    double firstMismatchPrice = 0.0; // Reference price at the first differing position
+
+    bool diverged() const
+    {
+        return mismatchedLevels > 0;
+    }
+};
+
+// Drift audit. The synchronizer hands over a REST snapshot, the level updates it recorded since
+// before the request, and a copy of its top levels. Everything here runs off the book lock.
+class BookAudit
+{
+  private:
+    // One side flattened into contiguous prices and quantities, so the comparison is a straight
+    // loop the compiler vectorizes
+    struct FlatSide
+    {
+        std::vector<double> prices;
+        std::vector<double> quantities;
+    };
+
+    FlatSide referenceBids;
+    FlatSide referenceAsks;
+    FlatSide liveBids;
+    FlatSide liveAsks;
+
+    template <typename Levels> static void flatten(const Levels &levels, FlatSide &out);
+    static void flatten(const std::vector<OrderBookLevel> &levels, size_t count, double worstPrice, bool bids,
+                        FlatSide &out);
+    static void compareSide(const FlatSide &reference, const FlatSide &live, BookSide side, bool bounded,
+                            BookAuditResult &result);
+
+  public:
+    // Rolls the snapshot forward to targetId by applying the updates with
+    // lastUpdateId < u <= targetId that fall inside its price range. An event straddling
+    // lastUpdateId is applied whole, as in the sync procedure, since its quantities are absolute.
+    static void rollForward(DepthSnapshot &snapshot, const std::vector<AuditDelta> &deltas, long long targetId);
+
+    // Compares the snapshot with the live window over the snapshot's price range. A bounded book
+    // may have pruned tail levels, so then only the levels both sides still hold count.
+    BookAuditResult compare(const DepthSnapshot &reference, const LevelWindow &live, bool bounded);
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "OrderBookData.h"
+#include <cstdint>
+#include <string>
+
+// Binary checkpoint of a single book used to warm start after a restart.
+// Layout: header, then bidCount bid (price, quantity) pairs, then askCount ask pairs.
+class BookCheckpoint
+{
+  private:
+    struct Header
+    {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t reserved;
+        int64_t lastUpdateId;
+        int64_t savedAtNs; // Wall-clock time the checkpoint was written
+        uint64_t bidCount;
+        uint64_t askCount;
+    };
+
+    static constexpr uint64_t MAGIC = 0x54504b434b4f4f42ULL; // "BOOKCKPT"
+    static constexpr uint32_t VERSION = 1;
+
+  public:
+    // Writes to a temporary file and renames it, so a crash never leaves a torn checkpoint
+    static bool save(const std::string &path, const OrderBookData &book);
+
+    // Loads the checkpoint if it exists, is well formed and is younger than maxAgeSeconds
+    static bool load(const std::string &path, OrderBookData &book, int64_t maxAgeSeconds);
+};
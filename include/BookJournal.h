@@ -0,0 +1,164 @@
+#pragma once
+
+#include "OrderBookData.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Journaled prices and quantities are fixed-point integers at this scale
+// (Binance publishes at most 8 decimals)
+constexpr double JOURNAL_FIXED_SCALE = 1e8;
+
+enum class JournalSide : uint8_t
+{
+    BID = 0,
+    ASK = 1
+};
+
+// One memory-mapped, append-only file holding a single column of fixed-size values.
+// The element count lives in the file header, so a column can be reopened and appended to.
+class JournalColumn
+{
+  private:
+    struct Header
+    {
+        uint64_t magic;
+        uint64_t elementSize;
+        uint64_t count;
+        uint64_t reserved[5];
+    };
+
+    static constexpr uint64_t MAGIC = 0x4c4f434b4f4f4231ULL; // "1BOOKCOL"
+    static constexpr size_t HEADER_SIZE = sizeof(Header);
+    static constexpr size_t INITIAL_CAPACITY = 1 << 16; // elements
+
+    int fd = -1;
+    char *base = nullptr;
+    size_t mappedSize = 0;
+    size_t elementSize = 0;
+    bool writable = false;
+
+    bool map(size_t size);
+    bool grow(size_t minimumSize);
+
+  public:
+    JournalColumn() = default;
+    ~JournalColumn();
+    JournalColumn(const JournalColumn &) = delete;
+    JournalColumn &operator=(const JournalColumn &) = delete;
+
+    bool open(const std::string &path, size_t valueSize, bool forWriting);
+    void close();
+
+    bool append(const void *value);
+    size_t size() const; // Rows that are both counted and inside this mapping
+
+    template <typename T> const T *values() const
+    {
+        return reinterpret_cast<const T *>(base + HEADER_SIZE);
+    }
+};
+
+// Index entry written with every full-book checkpoint
+struct JournalIndexEntry
+{
+    int64_t timestampNs;       // Wall-clock time the checkpoint was taken
+    int64_t updateId;          // Book update id at the checkpoint
+    uint64_t deltaOffset;      // Number of deltas journaled before the checkpoint
+    uint64_t checkpointOffset; // First row of this checkpoint in the checkpoint columns
+    uint64_t levelCount;       // Rows in the checkpoint (bids then asks)
+};
+
+// One journaled level change, decoded
+struct JournalDelta
+{
+    int64_t timestampNs;
+    long long updateId;
+    JournalSide side;
+    double price;
+    double quantity;
+};
+
+// The column files of one journal directory:
+//   deltas:      time | update id | side | price | quantity
+//   checkpoints: side | price | quantity
+//   index:       one JournalIndexEntry per checkpoint
+struct JournalFiles
+{
+    JournalColumn deltaTime;
+    JournalColumn deltaUpdateId;
+    JournalColumn deltaSide;
+    JournalColumn deltaPrice;
+    JournalColumn deltaQuantity;
+
+    JournalColumn checkpointSide;
+    JournalColumn checkpointPrice;
+    JournalColumn checkpointQuantity;
+
+    JournalColumn index;
+
+    bool open(const std::string &directory, bool forWriting);
+};
+
+// Writes every applied level change plus periodic full-book checkpoints
+class BookJournal
+{
+  private:
+    std::string directory;
+
+    JournalFiles files;
+
+    size_t deltasSinceCheckpoint = 0;
+    bool opened = false;
+
+    // Configuration
+    static constexpr size_t CHECKPOINT_INTERVAL = 100000; // deltas
+
+    void appendCheckpointLevel(JournalSide side, double price, double quantity);
+
+  public:
+    explicit BookJournal(const std::string &journalDirectory);
+    ~BookJournal() = default;
+
+    bool open();
+    bool isOpen() const;
+
+    void appendDelta(int64_t timestampNs, long long updateId, JournalSide side, double price, double quantity);
+    void appendCheckpoint(int64_t timestampNs, const OrderBookData &book);
+    bool isCheckpointDue() const;
+
+    static int64_t now();
+};
+
+// Read-only view over a journal directory for post-trade reconstruction.
+// Both queries seek to the latest checkpoint at or before the target and replay only the tail.
+// A journal still being written is read as of open(); open() again to see rows added since.
+class BookJournalReader
+{
+  private:
+    std::string directory;
+
+    JournalFiles files;
+
+    void replayDeltas(size_t begin, size_t end, OrderBookData &book) const;
+    size_t replayLimit(size_t nextCheckpoint) const;
+
+  public:
+    explicit BookJournalReader(const std::string &journalDirectory);
+
+    bool open();
+
+    size_t getDeltaCount() const;
+    size_t getCheckpointCount() const;
+
+    // Sequential access, e.g. for replaying the whole journal
+    JournalDelta getDelta(size_t index) const;
+    const JournalIndexEntry &getCheckpoint(size_t index) const;
+    void loadCheckpoint(const JournalIndexEntry &entry, OrderBookData &book) const;
+
+    // Rebuild the book as of wall-clock time T (ns since epoch); false if T precedes the journal
+    bool reconstructAt(int64_t timestampNs, OrderBookData &book) const;
+
+    // Rebuild the book as of the last update with u <= updateId
+    bool reconstructAtUpdateId(long long updateId, OrderBookData &book) const;
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "OrderBookData.h"
+#include "OrderBookLevel.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Top levels of one book as of one applied event
+struct BookView
+{
+    long long updateId = 0;
+    int64_t receiveTimeNs = 0; // Steady clock, when the event arrived
+    std::vector<OrderBookLevel> bids;
+    std::vector<OrderBookLevel> asks;
+};
+
+// Views of several books read at one instant; the buffers are reused across reads
+struct MultiBookView
+{
+    uint64_t epoch = 0;      // Publications completed before the read
+    bool consistent = false; // False if writers kept interleaving; each view is still whole
+    std::vector<BookView> views;
+};
+
+// The top levels of every symbol's book, one fixed-size row per symbol. Each synchronizer
+// rewrites its row after every applied event, under a per-row sequence lock, and bumps a shared
+// epoch as it starts. read() copies the requested rows between two loads of the epoch. If no
+// writer started in between, the copies form a single cut across the books. Writers never wait
+// on readers; a reader that raced a writer copies again.
+class BookViewTable
+{
+  private:
+    size_t capacity;
+    size_t depth;
+    std::atomic<size_t> rows{0};
+    alignas(64) std::atomic<uint64_t> epoch{0};
+
+    // Per row: sequence, stamps, level counts, then depth bid prices, bid quantities, ask prices
+    // and ask quantities, sized up front so writers never see them move
+    std::unique_ptr<std::atomic<uint32_t>[]> sequences;
+    std::unique_ptr<long long[]> updateIds;
+    std::unique_ptr<int64_t[]> receiveTimes;
+    std::unique_ptr<uint32_t[]> bidCounts;
+    std::unique_ptr<uint32_t[]> askCounts;
+    std::unique_ptr<double[]> levels;
+
+    std::vector<std::string> symbols;
+    mutable std::mutex symbolsMutex;
+
+    double *rowLevels(size_t slot) const;
+    void copyRow(size_t slot, BookView &view) const;
+
+  public:
+    static constexpr size_t DEFAULT_CAPACITY = 256;
+    static constexpr size_t DEFAULT_DEPTH = 10;
+    static constexpr int DEFAULT_READ_ATTEMPTS = 16;
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+    explicit BookViewTable(size_t maxSymbols = DEFAULT_CAPACITY, size_t levelsPerSide = DEFAULT_DEPTH);
+
+    // Returns the symbol's slot; throws once the table is full
+    size_t addSymbol(const std::string &symbol);
+    size_t findSymbol(const std::string &symbol) const;
+
+    // Single writer per slot, called with the book's lock held
+    void publish(size_t slot, const OrderBookData &book, long long updateId, int64_t receiveTimeNs);
+
+    // Any thread. Fills one view per slot, in order; true if the views form one cut
+    bool read(const std::vector<size_t> &slots, MultiBookView &out,
+              int maxAttempts = DEFAULT_READ_ATTEMPTS) const;
+
+    size_t getDepth() const;
+    size_t size() const;
+};
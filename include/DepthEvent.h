@@ -0,0 +1,27 @@
+#pragma once
+
+#include <chrono>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Price and quantity pairs in stream order; a zero quantity removes the level
+using DepthLevels = std::vector<std::pair<double, double>>;
+
+struct DepthEvent
+{
+    long long firstUpdateId = 0; // U
+    long long finalUpdateId = 0; // u
+    DepthLevels bids;
+    DepthLevels asks;
+    std::chrono::steady_clock::time_point timestamp;
+
+    DepthEvent() : timestamp(std::chrono::steady_clock::now())
+    {
+    }
+};
+
+// Parses a depthUpdate frame, raw or wrapped in a combined-stream {"stream":..,"data":..}, into
+// event. The event's level buffers are cleared and refilled, so a reused event keeps its
+// capacity and parsing allocates nothing. Returns false (with finalUpdateId 0) on malformed input.
+bool parseDepthUpdate(std::string_view json, DepthEvent &event);
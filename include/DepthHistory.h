@@ -0,0 +1,108 @@
+#pragma once
+
+#include "OrderBookData.h"
+#include "OrderBookLevel.h"
+#include "ProfiledMutex.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+struct DepthHistoryConfig
+{
+    size_t levels = 50;             // Per side
+    int64_t intervalMs = 100;       // One frame per interval while the book is updating
+    int64_t horizonSeconds = 300;   // Frames older than this are dropped
+    size_t memoryBytes = 4 << 20;   // Encoded frame arena; the oldest frames go first when full
+    size_t keyframeInterval = 50;   // Frames between full frames; bounds the decode work of a read
+};
+
+// Top levels of the book at one sample time
+struct DepthFrame
+{
+    int64_t timeNs = 0; // Steady clock; the state holds from here until the next frame
+    long long updateId = 0;
+    std::vector<OrderBookLevel> bids;
+    std::vector<OrderBookLevel> asks;
+};
+
+// Liquidity by price bucket over time. Row 0 is the highest price bucket and cells are row-major.
+// Each column holds the book as of the end of its time span.
+struct HeatmapGrid
+{
+    size_t rows = 0;
+    size_t columns = 0;
+    double priceLow = 0.0;
+    double priceHigh = 0.0;
+    int64_t fromNs = 0;
+    int64_t columnNs = 0;
+    std::vector<double> bidQuantity;
+    std::vector<double> askQuantity;
+    double maxQuantity = 0.0;
+};
+
+// Rolling, fixed-memory history of a book's top levels. The synchronizer samples the book on the
+// first event of every interval, so a frame is the book as it stood at the interval boundary.
+// Frames are delta-encoded against the previous frame, with a full keyframe every
+// keyframeInterval frames. Prices are stored as tick offsets and quantities as fixed-point
+// varints, in a byte ring that never grows. A read decodes forward from the nearest keyframe.
+class DepthHistory
+{
+  private:
+    struct FrameEntry
+    {
+        int64_t timeNs;
+        size_t offset;
+        uint32_t size;
+        bool keyframe;
+    };
+
+    // Fixed-point price in units of the keyframe's tick, and fixed-point quantity
+    using EncodedLevels = std::vector<std::pair<int64_t, int64_t>>;
+
+    DepthHistoryConfig config;
+    int64_t intervalNs;
+
+    // Shared with readers under historyMutex
+    std::vector<uint8_t> arena;
+    std::vector<FrameEntry> frames; // Ring; head is the oldest and always a keyframe
+    size_t head = 0;
+    size_t count = 0;
+    size_t writeOffset = 0;
+    mutable ProfiledMutex historyMutex{"DepthHistory::historyMutex"};
+
+    // Writer state, only touched by the sampling thread
+    int64_t lastSlot = -1;
+    size_t framesSinceKeyframe = 0;
+    int64_t priceUnit = 1;
+    EncodedLevels previousBids;
+    EncodedLevels previousAsks;
+    EncodedLevels currentBids;
+    EncodedLevels currentAsks;
+    std::vector<uint8_t> encoded;
+
+    bool encodeSide(const OrderBookData &book, bool bids, EncodedLevels &out) const;
+    void encodeFrame(long long updateId, bool keyframe);
+    void commitFrame(int64_t timeNs, bool keyframe);
+    void evictOldest();
+
+  public:
+    explicit DepthHistory(const DepthHistoryConfig &historyConfig = {});
+
+    // Called by the synchronizer with the book lock held, before each event is applied
+    void sample(const OrderBookData &book, int64_t nowNs);
+
+    // Visits the frame in effect at fromNs, then every frame up to toNs, in order. The frame
+    // is reused between calls.
+    void visitRange(int64_t fromNs, int64_t toNs, const std::function<void(const DepthFrame &)> &visitor) const;
+
+    // Fills grid (rows and columns set by the caller) over [fromNs, toNs] and [priceLow, priceHigh]
+    void readHeatmap(int64_t fromNs, int64_t toNs, double priceLow, double priceHigh, HeatmapGrid &grid) const;
+
+    const DepthHistoryConfig &getConfig() const;
+    size_t getFrameCount() const;
+    size_t getEncodedBytes() const; // Bytes held by the frames still in the ring
+    int64_t getOldestTimeNs() const;
+    int64_t getNewestTimeNs() const;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Quantity and notional summed over a run of levels
+struct DepthSum
+{
+    double quantity = 0.0;
+    double notional = 0.0; // Sum of price * quantity
+};
+
+// Prefix sums of one side of the book over price ticks, as two Fenwick trees (quantity and
+// notional). Slot 0 is an anchor tick just beyond the best price and slots run away from the
+// touch, so "everything at or better than price P" is a prefix. The index covers a fixed number
+// of ticks; levels farther out are left to the map. When the touch improves past the anchor, or
+// drifts so far out that little of the window is in use, update() asks for a rebuild and the
+// owner re-anchors the index from its map. A price off the tick grid would share a slot with its
+// neighbour, so it switches the index off until the next configure() and queries walk the map.
+class DepthIndex
+{
+  private:
+    bool bidSide;
+    double tickSize = 0.0;
+    size_t capacity = 0; // Slots, a power of two
+    int64_t anchorTick = 0;
+    bool anchored = false;
+    bool offGrid = false;
+
+    std::vector<double> quantityTree; // 1-based
+    std::vector<double> notionalTree;
+
+    int64_t toTick(double price) const;
+    bool isOnGrid(double price) const;
+    void add(size_t slot, double quantity, double notional);
+    void beginRebuild(double bestPrice);
+    void finishRebuild();
+
+  public:
+    explicit DepthIndex(bool isBidSide);
+
+    // ticks 0 disables the index, as does an unknown tick size
+    void configure(size_t ticks, double tick);
+    bool isActive() const;
+    bool isReady() const;   // Active and anchored, so queries can use it
+    bool isOffGrid() const; // A level fell between ticks; the index stays off until reconfigured
+    size_t getCapacity() const;
+
+    // Slot of a price: negative on the near side of the anchor, >= capacity past the window
+    int64_t slotOf(double price) const;
+    double priceOfSlot(int64_t slot) const;
+
+    // Half a tick on the touch side of a slot: lower_bound on the side's map with it finds the
+    // first level at or past the slot, for either comparator
+    double nearEdgeOfSlot(int64_t slot) const;
+
+    // Leading slots priced at or better than limitPrice; may exceed capacity or be negative
+    int64_t slotsWithin(double limitPrice) const;
+
+    // Applies a level change. False when the index must be rebuilt from the map first.
+    // Costs O(log capacity); the rebuild it may ask for is O(capacity), so O(log n) is amortized.
+    bool update(double price, double oldQuantity, double newQuantity);
+
+    // True once the touch has moved so far from the anchor that much of the window is unused
+    bool isDrifted(double bestPrice) const;
+
+    // Re-anchors next to the side's best price and reloads the levels inside the window. Levels
+    // iterate best first, as in BidsMap and AsksMap.
+    template <typename Levels> void rebuild(const Levels &levels);
+    void clear();
+
+    // Sum over slots [0, slots)
+    DepthSum prefix(size_t slots) const;
+
+    // Fewest leading slots whose quantity reaches target, minus one: the slot where target is
+    // reached. before holds the sum of the slots ahead of it. Returns capacity when the whole
+    // window holds less than target, with before holding the window's total.
+    size_t lowerBound(double target, DepthSum &before) const;
+};
+
+template <typename Levels> void DepthIndex::rebuild(const Levels &levels)
+{
+    if (!isActive() || levels.empty())
+    {
+        clear();
+        return;
+    }
+
+    if (offGrid)
+    {
+        return;
+    }
+
+    beginRebuild(levels.begin()->first);
+    for (const auto &[price, quantity] : levels)
+    {
+        int64_t slot = slotOf(price);
+        if (slot >= static_cast<int64_t>(capacity))
+        {
+            break;
+        }
+        if (!isOnGrid(price))
+        {
+            offGrid = true;
+            clear();
+            return;
+        }
+        quantityTree[static_cast<size_t>(slot) + 1] += quantity;
+        notionalTree[static_cast<size_t>(slot) + 1] += price * quantity;
+    }
+    finishRebuild();
+}
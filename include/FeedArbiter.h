@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct FeedConnectionStats
+{
+    size_t connectionId = 0;
+    bool connected = false;
+    uint64_t messages = 0;
+    uint64_t wins = 0;
+    uint64_t duplicates = 0;
+    uint64_t reconnects = 0;
+    double winRate = 0.0;  // Share of updates this connection delivered first
+    double avgLagMs = 0.0; // Average delay behind the winning copy when it lost
+    double maxLagMs = 0.0;
+};
+
+// Arbitrates between redundant connections carrying the same depth stream.
+// Every copy of an update carries the same final update id (u), so the first
+// copy with a u beyond everything already applied wins and later copies are dropped.
+class FeedArbiter
+{
+  private:
+    struct ConnectionCounters
+    {
+        std::atomic<bool> connected{false};
+        std::atomic<uint64_t> messages{0};
+        std::atomic<uint64_t> wins{0};
+        std::atomic<uint64_t> duplicates{0};
+        std::atomic<uint64_t> reconnects{0};
+        std::atomic<uint64_t> lagSamples{0};
+        std::atomic<uint64_t> lagNanosTotal{0};
+        std::atomic<uint64_t> lagNanosMax{0};
+    };
+
+    struct Arrival
+    {
+        long long updateId = 0;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    // Recent winning arrivals, indexed by update id, used to measure the loser's lag
+    static constexpr size_t ARRIVAL_HISTORY = 1024;
+
+    std::vector<std::unique_ptr<ConnectionCounters>> counters;
+    std::array<Arrival, ARRIVAL_HISTORY> arrivals{};
+    std::atomic<long long> lastWinningUpdateId{0};
+
+  public:
+    explicit FeedArbiter(size_t connectionCount);
+
+    // Returns true if this copy is the first to arrive and should be applied
+    bool arbitrate(size_t connectionId, long long finalUpdateId);
+
+    void setConnected(size_t connectionId, bool connected);
+    void recordReconnect(size_t connectionId);
+
+    size_t getConnectionCount() const;
+    std::vector<FeedConnectionStats> getStats() const;
+};
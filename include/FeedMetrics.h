@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+inline int64_t metricsNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Index of the calling thread's counter shard
+inline size_t metricsThreadSlot()
+{
+    static std::atomic<size_t> nextSlot{0};
+    thread_local size_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+}
+
+// Counter split into cache-line padded per-thread shards, so hot threads never share a line.
+// Increments are uncontended relaxed adds; reads sum the shards.
+class ShardedCounter
+{
+  private:
+    struct alignas(CACHE_LINE_SIZE) Shard
+    {
+        std::atomic<uint64_t> value{0};
+    };
+
+    static constexpr size_t SHARDS = 8;
+    std::array<Shard, SHARDS> shards;
+
+  public:
+    void add(uint64_t amount = 1)
+    {
+        shards[metricsThreadSlot() % SHARDS].value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    uint64_t load() const
+    {
+        uint64_t total = 0;
+        for (const auto &shard : shards)
+        {
+            total += shard.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+};
+
+// Last-value gauge on its own cache line
+class alignas(CACHE_LINE_SIZE) PaddedGauge
+{
+  private:
+    std::atomic<int64_t> value{0};
+
+  public:
+    void set(int64_t newValue)
+    {
+        value.store(newValue, std::memory_order_relaxed);
+    }
+
+    void setMax(int64_t candidate)
+    {
+        int64_t current = value.load(std::memory_order_relaxed);
+        while (candidate > current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    int64_t load() const
+    {
+        return value.load(std::memory_order_relaxed);
+    }
+};
+
+// Feed and sync health for one symbol
+struct SyncMetrics
+{
+    ShardedCounter messages;      // Depth frames received, all replicas
+    ShardedCounter parseFailures; // Frames that did not parse into a depth event
+    ShardedCounter gaps;          // Sequence gaps detected while synchronized
+    ShardedCounter resyncs;       // Resets back to snapshot sync
+    ShardedCounter bufferRestarts; // Sync buffers dropped at a gap in the buffered stream
+    ShardedCounter audits;           // Drift audits against a REST snapshot
+    ShardedCounter auditDivergences; // Audits that found the book differed from the snapshot
+    ShardedCounter resyncDurationTotalNs;
+
+    PaddedGauge bufferOccupancy; // Distinct price levels in the sync buffer
+    PaddedGauge latestReceivedUpdateId;
+    PaddedGauge resyncStartNs;
+    PaddedGauge lastResyncDurationNs;
+    PaddedGauge loopLagNs; // Background loop wake-up delay beyond its sleep
+};
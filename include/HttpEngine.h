@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <curl/curl.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct HttpResponse
+{
+    long status = 0;
+    std::string body;
+    std::string error;
+    long usedWeight = -1;      // X-MBX-USED-WEIGHT-1M reported by Binance, if any
+    long retryAfterSeconds = 0; // Retry-After on 418/429
+
+    bool ok() const
+    {
+        return error.empty() && status == 200;
+    }
+};
+
+// Shared HTTP client: one thread drives a curl multi handle, so many requests run
+// concurrently over persistent keep-alive connections with DNS and TLS session reuse.
+// Requests are dispatched against Binance's per-minute request-weight budget.
+class HttpEngine
+{
+  public:
+    using Completion = std::function<void(HttpResponse &&)>;
+
+    static HttpEngine &instance();
+
+    // Queue a GET; the completion runs on the engine thread. Every request completes exactly once,
+    // with an error if the engine shuts down first.
+    void submit(const std::string &url, int weight, Completion completion);
+
+    // True on the engine thread, where waiting for a response would deadlock
+    bool isEngineThread() const;
+
+    int getUsedWeight() const;
+    size_t getPendingCount() const;
+
+  private:
+    struct Request
+    {
+        std::string url;
+        int weight = 0;
+        Completion completion;
+        CURL *easy = nullptr;
+        HttpResponse response;
+    };
+
+    struct WeightCharge
+    {
+        std::chrono::steady_clock::time_point time;
+        int weight;
+    };
+
+    CURLM *multi = nullptr;
+    CURLSH *share = nullptr;
+
+    // Requests waiting for weight budget, guarded by queueMutex
+    std::deque<std::unique_ptr<Request>> pending;
+    mutable std::mutex queueMutex;
+
+    // Engine-thread state
+    std::unordered_map<CURL *, std::unique_ptr<Request>> inFlight;
+    std::vector<CURL *> idleHandles;
+    std::deque<WeightCharge> weightWindow;
+    int windowWeight = 0;
+    long serverUsedWeight = 0;
+    std::chrono::steady_clock::time_point serverWeightTime;
+    std::chrono::steady_clock::time_point backoffUntil;
+
+    std::atomic<int> usedWeight{0};
+    std::atomic<bool> running{false};
+    std::thread engineThread;
+
+    // Configuration
+    static constexpr int WEIGHT_LIMIT_PER_MINUTE = 6000;
+    static constexpr int WEIGHT_BUDGET = WEIGHT_LIMIT_PER_MINUTE * 8 / 10; // Headroom for other clients
+    static constexpr long REQUEST_TIMEOUT_S = 10;
+    static constexpr int POLL_TIMEOUT_MS = 100;
+
+    HttpEngine();
+    ~HttpEngine();
+    HttpEngine(const HttpEngine &) = delete;
+    HttpEngine &operator=(const HttpEngine &) = delete;
+
+    void eventLoop();
+    void dispatchPending();
+    void completeTransfers();
+    void failRemaining();
+    void expireWeightWindow(std::chrono::steady_clock::time_point now);
+    int currentWeight(std::chrono::steady_clock::time_point now) const;
+
+    CURL *acquireHandle();
+    void releaseHandle(CURL *easy);
+    void configureHandle(Request &request);
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "SpscRing.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class BookSide : uint8_t
+{
+    BID,
+    ASK
+};
+
+namespace LevelChangeFlags
+{
+constexpr uint8_t AT_BBO = 1;        // The price was or became the best on its side
+constexpr uint8_t BBO_CHANGED = 2;   // The event moved the best bid or ask, price or quantity
+constexpr uint8_t END_OF_EVENT = 4;  // Last change of its depth event
+constexpr uint8_t BOOK_REPLACED = 8; // Snapshot, resync or backfill; carries no price, re-read the book
+} // namespace LevelChangeFlags
+
+// One price level change, as applied to the book
+struct LevelChange
+{
+    long long updateId = 0;    // Final update id (u) of the depth event
+    int64_t receiveTimeNs = 0; // Steady clock, when the event arrived
+    double price = 0.0;
+    double oldQuantity = 0.0; // 0 for a new level
+    double newQuantity = 0.0; // 0 for a removed level
+    BookSide side = BookSide::BID;
+    uint8_t flags = 0;
+};
+
+struct SubscriptionFilter
+{
+    size_t topLevels = 0; // Only changes within the best N levels before or after the event; 0 for all
+    bool bboOnly = false; // Only changes at the best bid or ask
+};
+
+// A subscriber's queue. The applying thread pushes into it and never waits: when the ring is
+// full the change is dropped and counted, and the subscriber should re-read the book.
+class LevelSubscription
+{
+    friend class LevelChangeHub;
+
+  private:
+    SubscriptionFilter filter;
+    SpscRing<LevelChange> ring;
+    std::function<void(const LevelChange &)> callback; // Empty for polled subscriptions
+    std::atomic<uint64_t> dropped{0};
+
+  public:
+    LevelSubscription(const SubscriptionFilter &subscriptionFilter, size_t capacity,
+                      std::function<void(const LevelChange &)> changeCallback);
+
+    // Polled subscriptions only, from a single consumer thread
+    bool poll(LevelChange &change);
+
+    uint64_t getDropped() const;
+    const SubscriptionFilter &getFilter() const;
+};
+
+using SubscriptionHandle = std::shared_ptr<LevelSubscription>;
+
+// Price of the Nth best level on each side, before and after an event. NaN when the side has
+// fewer than N levels, so every change on it is inside the top N.
+struct DepthHorizon
+{
+    double bidBefore = 0.0;
+    double askBefore = 0.0;
+    double bidAfter = 0.0;
+    double askAfter = 0.0;
+};
+
+// Fans level changes out to subscribers. Callback subscriptions are drained by a dispatcher
+// thread, so a slow callback delays other callbacks but never the thread applying the book.
+class LevelChangeHub
+{
+  public:
+    // Immutable subscriber set, replaced on every subscribe or unsubscribe
+    struct SubscriberList
+    {
+        std::vector<SubscriptionHandle> subscriptions;
+        std::vector<size_t> horizonSlots; // Per subscription, index into depths; unused without topLevels
+        std::vector<size_t> depths;       // Distinct topLevels values the publisher must measure
+        bool hasCallbacks = false;
+    };
+    using Subscribers = std::shared_ptr<const SubscriberList>;
+
+    static constexpr size_t DEFAULT_CAPACITY = 4096;
+
+  private:
+    std::atomic<Subscribers> subscribers;
+    std::atomic<bool> anySubscribers{false};
+    std::mutex subscribeMutex; // Serializes list rebuilds
+
+    std::thread dispatcher;
+    std::atomic<bool> dispatching{false};
+    std::atomic<uint64_t> publishedBatches{0};
+
+    void replaceSubscribers(std::vector<SubscriptionHandle> subscriptions);
+    void dispatchLoop();
+
+  public:
+    LevelChangeHub() = default;
+    ~LevelChangeHub();
+
+    LevelChangeHub(const LevelChangeHub &) = delete;
+    LevelChangeHub &operator=(const LevelChangeHub &) = delete;
+
+    SubscriptionHandle subscribe(const SubscriptionFilter &filter, std::function<void(const LevelChange &)> callback,
+                                 size_t capacity = DEFAULT_CAPACITY);
+    SubscriptionHandle subscribe(const SubscriptionFilter &filter, size_t capacity = DEFAULT_CAPACITY);
+
+    // The callback may run once more if the dispatcher is already inside it
+    void unsubscribe(const SubscriptionHandle &subscription);
+
+    // Publisher side; a single producer at a time. nullptr when nobody is subscribed.
+    Subscribers getSubscribers() const;
+    void publish(const SubscriberList &list, const std::vector<LevelChange> &changes,
+                 const std::vector<DepthHorizon> &horizons);
+};
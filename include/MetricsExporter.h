@@ -0,0 +1,58 @@
+#pragma once
+
+#include "FeedArbiter.h"
+#include <utility> // Boost 1.74 asio uses std::exchange without including it under C++20
+#include <boost/asio.hpp>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class OrderBookSynchronizer;
+
+// Serves feed and sync health in Prometheus text format on a local HTTP port (GET /metrics).
+// Scrapes only read atomics, so the exporter never touches the book or its locks.
+class MetricsExporter
+{
+  private:
+    struct Source
+    {
+        std::string symbol;
+        const OrderBookSynchronizer *synchronizer = nullptr;
+        std::function<std::vector<FeedConnectionStats>()> feedStats;
+
+        // For the messages/sec gauge between scrapes
+        uint64_t lastMessages = 0;
+        std::chrono::steady_clock::time_point lastScrape;
+    };
+
+    boost::asio::io_context ioContext;
+    boost::asio::ip::tcp::acceptor acceptor;
+    std::thread serverThread;
+    bool running = false;
+
+    std::vector<Source> sources;
+    std::mutex sourcesMutex;
+
+    void acceptNext();
+    void handleConnection(std::shared_ptr<boost::asio::ip::tcp::socket> socket);
+
+  public:
+    MetricsExporter();
+    ~MetricsExporter();
+
+    void addSource(const std::string &symbol, const OrderBookSynchronizer *synchronizer,
+                   std::function<std::vector<FeedConnectionStats>()> feedStats = nullptr);
+
+    // Once this returns no scrape reads the symbol's synchronizer
+    void removeSource(const std::string &symbol);
+
+    // Binds to 127.0.0.1:port; returns false if the port is unavailable
+    bool start(unsigned short port);
+    void stop();
+
+    std::string render();
+};
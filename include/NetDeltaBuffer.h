@@ -0,0 +1,55 @@
+#pragma once
+
+#include "DepthEvent.h"
+#include <chrono>
+#include <cstddef>
+#include <map>
+
+// Net effect of the depth events buffered while a book syncs. Each price keeps the last quantity
+// written to it and the u of the event that wrote it, so memory grows with distinct prices
+// rather than with the number of events. Given a snapshot at lastUpdateId, the entries written
+// after it are exactly what the snapshot is missing, which is all replay needs.
+class NetDeltaBuffer
+{
+  private:
+    struct Entry
+    {
+        double quantity;
+        long long updateId; // u of the event that last wrote this price
+    };
+
+    std::map<double, Entry> bids;
+    std::map<double, Entry> asks;
+
+    // Contiguous run of events folded so far: U of the first, u of the newest
+    long long firstUpdateId = 0;
+    long long finalUpdateId = 0;
+    size_t eventCount = 0;
+    std::chrono::steady_clock::time_point lastTimestamp;
+
+    static void foldSide(std::map<double, Entry> &side, const DepthLevels &levels, long long updateId);
+    static void extractSide(const std::map<double, Entry> &side, long long afterId, DepthLevels &out);
+
+  public:
+    enum class FoldResult
+    {
+        FOLDED,
+        DUPLICATE, // Nothing newer than what is already folded, e.g. a late copy from another feed
+        RESTARTED  // The event did not follow on; everything before it was dropped
+    };
+
+    FoldResult fold(const DepthEvent &event);
+
+    // True when the folded run covers lastUpdateId + 1, i.e. the stream reaches back to the snapshot
+    bool reaches(long long lastUpdateId) const;
+
+    // One event holding every level written after lastUpdateId, spanning [lastUpdateId + 1, u]
+    void extractAfter(long long lastUpdateId, DepthEvent &out) const;
+
+    void clear();
+    bool empty() const;
+    size_t getLevelCount() const;
+    size_t getEventCount() const;
+    long long getFirstUpdateId() const;
+    long long getFinalUpdateId() const;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+
+// Per-thread free list of fixed-size blocks. Freed blocks are kept for reuse on the freeing
+// thread, up to MAX_CACHED, so a book that churns levels at a stable depth stops touching the
+// heap once its node count has peaked. A block may be freed on another thread than the one that
+// allocated it; it then simply joins that thread's list.
+template <size_t Size> class NodeFreeList
+{
+  private:
+    struct Block
+    {
+        Block *next;
+    };
+
+    struct List
+    {
+        Block *head = nullptr;
+        size_t count = 0;
+
+        ~List()
+        {
+            while (head)
+            {
+                Block *block = head;
+                head = block->next;
+                ::operator delete(block);
+            }
+            // Anything freed during later thread-exit teardown goes straight to the heap
+            count = MAX_CACHED;
+        }
+    };
+
+    static constexpr size_t BLOCK_SIZE = Size > sizeof(Block) ? Size : sizeof(Block);
+
+    static List &local()
+    {
+        thread_local List list;
+        return list;
+    }
+
+  public:
+    static constexpr size_t MAX_CACHED = 1 << 16;
+
+    static void *allocate()
+    {
+        List &list = local();
+        if (Block *block = list.head)
+        {
+            list.head = block->next;
+            list.count--;
+            return block;
+        }
+        return ::operator new(BLOCK_SIZE);
+    }
+
+    static void release(void *pointer)
+    {
+        List &list = local();
+        if (list.count >= MAX_CACHED)
+        {
+            ::operator delete(pointer);
+            return;
+        }
+        Block *block = static_cast<Block *>(pointer);
+        block->next = list.head;
+        list.head = block;
+        list.count++;
+    }
+};
+
+// Stateless allocator for node-based containers: single-node requests come from the calling
+// thread's NodeFreeList, anything larger from the default allocator.
+template <typename T> class NodePoolAllocator
+{
+  public:
+    using value_type = T;
+
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "over-aligned nodes are not pooled");
+
+    NodePoolAllocator() noexcept = default;
+    template <typename U> NodePoolAllocator(const NodePoolAllocator<U> &) noexcept
+    {
+    }
+
+    T *allocate(size_t n)
+    {
+        if (n == 1)
+        {
+            return static_cast<T *>(NodeFreeList<sizeof(T)>::allocate());
+        }
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *pointer, size_t n) noexcept
+    {
+        if (n == 1)
+        {
+            NodeFreeList<sizeof(T)>::release(pointer);
+            return;
+        }
+        std::allocator<T>().deallocate(pointer, n);
+    }
+
+    template <typename U> bool operator==(const NodePoolAllocator<U> &) const noexcept
+    {
+        return true;
+    }
+};
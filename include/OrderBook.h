@@ -1,25 +1,27 @@
 #pragma once
 
-#include "AveragePrice.h"
+#include "OrderBookEngine.h"
 #include "OrderBookManager.h"
-#include "OrderBookSynchronizer.h"
 #include "OrderBookUI.h"
-#include "WebSocket.h"
 #include <atomic>
 #include <string>
 
 extern std::atomic<bool> g_running;
 
+// The terminal application: one symbol from the engine, shown through the UI
 class OrderBook
 {
   private:
     std::string symbol;
-    AveragePrice avgPrice;
+    OrderBookEngine engine;
+    OrderBookSynchronizer &synchronizer;
     OrderBookManager orderBookManager;
-    OrderBookSynchronizer synchronizer;
-    WebSocket ws;
     OrderBookUI ui;
 
+    static constexpr unsigned short DEFAULT_METRICS_PORT = 9464;
+
+    static SymbolConfig configFromEnvironment(const std::string &tradingSymbol);
+
   public:
     OrderBook(const std::string &tradingSymbol);
     ~OrderBook() = default;
@@ -1,13 +1,97 @@
 #pragma once
 
+#include "DepthIndex.h"
+#include "NodePool.h"
 #include "OrderBookLevel.h"
+#include <cstddef>
+#include <cstdint>
 #include <map>
 #include <vector>
 
 // Bids: highest to lowest (reverse order)
 // Asks: lowest to highest (normal order)
-using BidsMap = std::map<double, double, std::greater<double>>;
-using AsksMap = std::map<double, double>;
+// Nodes come from a per-thread pool, so level churn at a stable depth does not allocate
+using BidsMap = std::map<double, double, std::greater<double>, NodePoolAllocator<std::pair<const double, double>>>;
+using AsksMap = std::map<double, double, std::less<double>, NodePoolAllocator<std::pair<const double, double>>>;
+
+// Optional cap on how much of each side is kept. Levels past the cap are dropped, and the
+// side is treated as unknown beyond the last dropped price until the next snapshot.
+struct DepthBound
+{
+    size_t maxLevels = 0;        // Keep the best N levels per side (0 = no limit)
+    double maxDistancePct = 0.0; // Keep levels within X% of mid (0 = no limit)
+
+    bool isBounded() const
+    {
+        return maxLevels > 0 || maxDistancePct > 0.0;
+    }
+};
+
+// A level dropped by the depth bound
+struct PrunedLevel
+{
+    bool isBid = true;
+    double price = 0.0;
+};
+
+// Book grouped into fixed-width price buckets of a whole number of ticks.
+// Bids round down and asks round up to their bucket, so a bucket never crosses the spread.
+struct AggregationBucket
+{
+    double quantity = 0.0;
+    size_t levels = 0; // Levels in the bucket; it is dropped at zero rather than at a float sum of zero
+};
+
+struct AggregationView
+{
+    size_t ticks = 1;
+    double bucketSize = 0.0;
+    template <typename Compare>
+    using BucketMap =
+        std::map<int64_t, AggregationBucket, Compare, NodePoolAllocator<std::pair<const int64_t, AggregationBucket>>>;
+
+    BucketMap<std::greater<int64_t>> bids; // Bucket index, best first
+    BucketMap<std::less<int64_t>> asks;
+};
+
+// Best bid and ask; zeros for an empty side
+struct TopOfBook
+{
+    double bidPrice = 0.0;
+    double bidQuantity = 0.0;
+    double askPrice = 0.0;
+    double askQuantity = 0.0;
+
+    bool operator==(const TopOfBook &other) const = default;
+};
+
+// Result of walking one side from the touch for a quantity
+struct FillEstimate
+{
+    double quantity = 0.0; // Filled; less than requested when the side runs out
+    double notional = 0.0;
+    double averagePrice = 0.0;
+    double worstPrice = 0.0; // Last level touched
+};
+
+// Caller-owned buffers for copying a slice of both sides without allocating.
+// Size bids/asks once; copyWindow overwrites rows in place.
+// Each side is anchored by the price of its first row, 0 for the touch. A copy seeks the anchor in
+// O(log n), moves it by `scroll` rows and writes it back, so a window deep in the book costs
+// O(log n + rows) to read rather than a walk from the top.
+struct LevelWindow
+{
+    double bidAnchor = 0.0;
+    double askAnchor = 0.0;
+    long scroll = 0; // Rows to move both sides by, away from the touch when positive; reset by the copy
+    std::vector<OrderBookLevel> bids;
+    std::vector<OrderBookLevel> asks;
+
+    size_t bidCount = 0; // Rows written
+    size_t askCount = 0;
+    size_t totalBids = 0; // Depth of each side
+    size_t totalAsks = 0;
+};
 
 class OrderBookData
 {
@@ -16,6 +100,35 @@ class OrderBookData
     AsksMap asks_;
     long long lastUpdateId_;
 
+    // Bounded-depth mode
+    DepthBound bound_;
+    double bidFloor_;   // Bids at or below this price are unknown
+    double askCeiling_; // Asks at or above this price are unknown
+
+    // Aggregation views, kept current on every level change
+    std::vector<AggregationView> views_;
+    double tickSize_;
+    bool tickSizeFixed_;
+
+    // Optional prefix-sum index over price ticks for liquidity queries
+    size_t indexTicks_;
+    DepthIndex bidIndex_;
+    DepthIndex askIndex_;
+
+    // Levels are kept up to this multiple of the bound so small moves don't force a refill
+    static constexpr size_t BOUND_SLACK_FACTOR = 2;
+
+    void resetCoverage();
+    void eraseBid(BidsMap::iterator it);
+    void eraseAsk(AsksMap::iterator it);
+
+    void inferTickSize();
+    void rebuildViews();
+    void updateViews(bool isBid, double price, double oldQuantity, double newQuantity);
+
+    void rebuildIndex();
+    void updateIndex(bool isBid, double price, double oldQuantity, double newQuantity);
+
   public:
     OrderBookData();
 
@@ -27,7 +140,39 @@ class OrderBookData
     AsksMap &getAsks();
     void setLastUpdateId(long long id);
 
+    // Level updates; a zero quantity removes the level. Updates in the unknown region are ignored
+    // and return false.
+    bool setBid(double price, double quantity);
+    bool setAsk(double price, double quantity);
+
+    // Replace both sides, e.g. from a snapshot, and re-apply the depth bound
+    void replaceLevels(const BidsMap &bids, const AsksMap &asks, long long updateId);
+
+    // Bounded-depth mode
+    void setDepthBound(const DepthBound &bound);
+    const DepthBound &getDepthBound() const;
+    size_t getLevelCapacity() const;
+    void enforceDepthBound(std::vector<PrunedLevel> *pruned = nullptr); // Appends what it drops
+    bool needsRefill() const;
+
+    // Aggregation views, registered in ticks. The tick size is inferred from each snapshot unless set,
+    // normally from the exchange's PRICE_FILTER.
+    void setTickSize(double tickSize);
+    double getTickSize() const;
+    void addAggregationView(size_t ticks);
+    void copyAggregatedWindow(size_t ticks, LevelWindow &window) const;
+
+    // Liquidity index over the best `ticks` ticks of each side (0 disables), kept in amortized
+    // O(log n) per level change: a re-anchor rebuilds it in O(ticks). The queries answer in
+    // O(log n) inside that window and walk the map past it, or throughout when no index is set
+    // or a level falls off the tick grid.
+    void setDepthIndex(size_t ticks);
+    FillEstimate estimateFill(bool bidSide, double quantity) const; // Bids for a sell, asks for a buy
+    DepthSum depthWithinBps(bool bidSide, double bps) const;        // Levels within bps of the mid
+
     std::vector<OrderBookLevel> getTopBids(int levels = 5) const;
     std::vector<OrderBookLevel> getTopAsks(int levels = 5) const;
+    void copyWindow(LevelWindow &window) const;
+    TopOfBook getTopOfBook() const;
     void clear();
 };
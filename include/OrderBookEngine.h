@@ -0,0 +1,80 @@
+#pragma once
+
+#include "AnalyticsTable.h"
+#include "AveragePrice.h"
+#include "BookViewTable.h"
+#include "DepthHistory.h"
+#include "FeedArbiter.h"
+#include "OrderBookData.h"
+#include "OrderBookSynchronizer.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Per-symbol settings, fixed once the symbol is added
+struct SymbolConfig
+{
+    DepthBound depthBound;                // Default keeps every level
+    std::vector<size_t> aggregationTicks; // Bucketed views to maintain; 1 tick needs none
+    std::string checkpointPath;           // Warm-start file; empty disables checkpoints
+    std::string journalDirectory;         // Delta journal directory; empty disables the journal
+    bool recordHistory = false;           // Keep a rolling depth history for heatmaps and features
+    DepthHistoryConfig history;
+    size_t depthIndexTicks = 0;           // Prefix-sum liquidity index over this many ticks per side; 0 disables
+    int auditIntervalSeconds = 0;         // Compare against a REST snapshot this often; 0 disables
+    bool auditRepair = true;              // Resync when an audit finds drift, rather than only report it
+};
+
+// Embeddable order book engine: the feed handler, sync pipelines and books for a set of symbols,
+// with no UI. Add symbols, start(), then read each book through its synchronizer from any thread.
+// Symbols can also be added and removed while running without disturbing the other books.
+// The feed handler and exporter stay in the implementation, so embedding needs neither
+// websocketpp, boost.asio nor jsoncpp.
+class OrderBookEngine
+{
+  private:
+    struct SymbolBook;
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+
+    SymbolBook *findBook(const std::string &symbol) const;
+
+  public:
+    OrderBookEngine();
+    explicit OrderBookEngine(size_t feedConnections);
+    ~OrderBookEngine();
+
+    OrderBookEngine(const OrderBookEngine &) = delete;
+    OrderBookEngine &operator=(const OrderBookEngine &) = delete;
+
+    // Registers the symbol's depth and bookTicker streams. After start() the streams are
+    // subscribed on the live connections and the symbol's sync pipeline starts right away.
+    OrderBookSynchronizer &addSymbol(const std::string &symbol, const SymbolConfig &config = {});
+
+    // Unsubscribes the symbol's streams and stops and destroys its book; pointers returned for it
+    // are invalid afterwards. Its analytics and view rows stay, reading as an empty book, and are
+    // reused if the symbol is added again. False if it was never added.
+    bool removeSymbol(const std::string &symbol);
+
+    void start();
+    void stop();
+
+    // Prometheus endpoint for every added symbol; false if the port is taken
+    bool startMetrics(unsigned short port);
+
+    // nullptr for symbols that were never added or have been removed
+    OrderBookSynchronizer *getSynchronizer(const std::string &symbol) const;
+    AveragePrice *getAveragePrice(const std::string &symbol) const;
+    const DepthHistory *getDepthHistory(const std::string &symbol) const; // nullptr unless recorded
+
+    std::vector<FeedConnectionStats> getFeedStats(const std::string &symbol) const;
+
+    // Top of book of every symbol, one row per symbol in the order they were added
+    const AnalyticsTable &getAnalytics() const;
+
+    // Top levels of several books as of one instant, stamped with each book's update id and
+    // receive time. Resolve slots once with getBookViews().findSymbol() for repeated reads.
+    const BookViewTable &getBookViews() const;
+    bool readBooks(const std::vector<std::string> &symbols, MultiBookView &out) const;
+};
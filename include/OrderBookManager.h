@@ -1,6 +1,7 @@
 #pragma once
 
 #include "OrderBookData.h"
+#include "ProfiledMutex.h"
 #include "utils.h"
 #include <atomic>
 #include <functional>
@@ -13,7 +14,7 @@ class OrderBookManager
 {
   private:
     OrderBookData orderbook;
-    mutable std::mutex orderbook_mutex;
+    mutable ProfiledMutex orderbook_mutex{"OrderBookManager::orderbook_mutex"};
     std::function<void()> updateCallback;
     std::atomic<bool> initialized;
 
@@ -28,11 +29,14 @@ class OrderBookManager
 
     OrderBookData getOrderBookSnapshot() const;
     std::pair<std::vector<OrderBookLevel>, std::vector<OrderBookLevel>> getTopLevels(int levels = 5) const;
+    void copyLevelWindow(LevelWindow &window) const;
+    void copyAggregatedWindow(size_t ticks, LevelWindow &window) const;
 
     // Callback for UI updates
     void setUpdateCallback(const std::function<void()> &callback);
 
     // Status
     bool isInitialized() const;
+    bool isStale() const;
     void reset();
 };
@@ -1,26 +1,41 @@
 #pragma once
 
+#include "AnalyticsTable.h"
 #include "BinanceAPI.h"
+#include "BookAudit.h"
+#include "BookViewTable.h"
+#include "BookCheckpoint.h"
+#include "BookJournal.h"
+#include "DepthEvent.h"
+#include "DepthHistory.h"
+#include "FeedMetrics.h"
+#include "LevelSubscription.h"
+#include "NetDeltaBuffer.h"
 #include "OrderBookData.h"
+#include "ProfiledMutex.h"
+#include "SyncExecutor.h"
 #include "utils.h"
 #include <atomic>
 #include <functional>
+#include <future>
+#include <map>
+#include <memory>
 #include <mutex>
-#include <queue>
-#include <thread>
+#include <string_view>
 
-struct DepthEvent
+// A REST response the pipeline is awaiting; cancel() resumes the pipeline without it
+struct RestFetch
 {
-    long long firstUpdateId = 0; // U
-    long long finalUpdateId = 0; // u
-    BidsMap bids;
-    AsksMap asks;
-    std::string rawJson;
-    std::chrono::steady_clock::time_point timestamp;
-
-    DepthEvent() : timestamp(std::chrono::steady_clock::now())
-    {
-    }
+    std::mutex mutex;
+    std::coroutine_handle<> waiter;
+    bool cancelled = false;
+
+    void cancel();
+};
+
+template <typename Result> struct PendingFetch : RestFetch
+{
+    Result result{};
 };
 
 class OrderBookSynchronizer
@@ -29,30 +44,94 @@ class OrderBookSynchronizer
     std::string symbol;
     std::atomic<SyncState> state{SyncState::INITIALIZING};
 
-    // Event buffering
-    std::queue<DepthEvent> eventBuffer;
-    mutable std::mutex bufferMutex;
+    // Event buffering: events seen while syncing, folded into their net effect per price
+    NetDeltaBuffer eventBuffer;
+    DepthEvent replayEvent; // Reused to replay the buffer onto the snapshot
+    mutable ProfiledMutex bufferMutex{"OrderBookSynchronizer::bufferMutex"};
     std::atomic<long long> firstBufferedEventU{0};
 
     // Order book state
     OrderBookData orderBook;
-    mutable std::mutex orderBookMutex;
+    mutable ProfiledMutex orderBookMutex{"OrderBookSynchronizer::orderBookMutex"};
     std::atomic<long long> localUpdateId{0};
-
-    // Snapshot handling
-    std::future<DepthSnapshot> snapshotFuture;
-    std::atomic<bool> snapshotRequested{false};
+    std::atomic<bool> refillNeeded{false};
+    std::atomic<uint64_t> syncGeneration{0}; // Bumped by every reset
+
+    // Staged sync: a shallow snapshot publishes the top of book first, then the deep levels are
+    // merged in. Until then prices beyond the shallow horizon are partial, and every change there
+    // is remembered by price with its u, so the merge never overwrites a newer live update.
+    std::atomic<bool> backfillPending{false};
+    long long shallowSnapshotId = 0;
+    double bidHorizon = 0.0; // Worst bid in the shallow snapshot
+    double askHorizon = 0.0; // Worst ask in the shallow snapshot
+    std::map<double, long long> bidTouches;
+    std::map<double, long long> askTouches;
 
     // Callbacks
     std::function<void()> updateCallback;
 
-    // Background processing
-    std::thread processingThread;
+    // Typed level changes; the buffers are reused under orderBookMutex
+    LevelChangeHub changeHub;
+    std::vector<LevelChange> pendingChanges;
+    std::vector<DepthHorizon> pendingHorizons;
+    std::vector<PrunedLevel> prunedLevels;
+
+    // Optional cross-symbol table; this book's row is rewritten on every BBO change
+    AnalyticsTable *analyticsTable = nullptr;
+    size_t analyticsSlot = 0;
+
+    // Optional multi-book view table; this book's row is rewritten after every event
+    BookViewTable *viewTable = nullptr;
+    size_t viewSlot = 0;
+
+    // Optional delta journal, written under orderBookMutex
+    BookJournal *journal = nullptr;
+
+    // Optional rolling depth history, sampled under orderBookMutex
+    DepthHistory *depthHistory = nullptr;
+
+    // Warm start: a checkpointed book shown as stale until the snapshot replaces it
+    std::string checkpointPath;
+    std::atomic<bool> stale{false};
+    std::chrono::steady_clock::time_point lastCheckpointSave;
+
+    // Drift audit: every auditInterval the pipeline compares the book with a fresh REST snapshot,
+    // and resyncs on a divergence when auditRepair is set. Its state is only touched by the pipeline.
+    std::chrono::seconds auditInterval{0};
+    bool auditRepair = true;
+    std::chrono::steady_clock::time_point nextAudit;
+    BookAudit audit;
+    LevelWindow auditWindow;
+
+    // Raw level updates recorded while an audit's snapshot is in flight, guarded by orderBookMutex.
+    // Reserved when the audit begins, so the applying thread only appends, and freed when it ends.
+    std::vector<AuditDelta> auditDeltas;
+    bool auditCapturing = false;
+    bool auditBroken = false; // Capacity ran out or the book was replaced since the audit began
+
+    // Health metrics; counters are safe to bump from const paths
+    mutable SyncMetrics metrics;
+
+    // Sync pipeline coroutine on the shared executor; woken by new events, resets and stop()
+    AsyncSignal wakeSignal;
+    std::promise<void> pipelineDone;
+    std::future<void> pipelineFinished;
     std::atomic<bool> running{false};
+    std::shared_ptr<RestFetch> activeFetch; // Guarded by fetchMutex; stop() cancels it
+    std::mutex fetchMutex;
 
     // Configuration
-    static constexpr size_t MAX_BUFFER_SIZE = 1000;
     static constexpr int SNAPSHOT_RETRY_DELAY_MS = 1000;
+    static constexpr int ERROR_RETRY_DELAY_S = 5;
+    static constexpr int IDLE_WAIT_S = 1;
+    static constexpr size_t MAX_SNAPSHOT_LIMIT = 5000;
+    static constexpr int SHALLOW_SNAPSHOT_LIMIT = 100; // Weight 5 instead of 250
+    static constexpr int CHECKPOINT_SAVE_INTERVAL_S = 30;
+    static constexpr int64_t MAX_CHECKPOINT_AGE_S = 3600;
+    static constexpr size_t AUDIT_CAPACITY = 1 << 16; // Level updates held while the snapshot is in flight
+    static constexpr int AUDIT_CATCH_UP_MS = 50;
+    static constexpr int AUDIT_CATCH_UP_ATTEMPTS = 40;
+    static constexpr size_t AUDIT_WINDOW_SLACK = 64; // Live rows beyond the snapshot depth, to show extra levels
 
   public:
     explicit OrderBookSynchronizer(const std::string &tradingSymbol);
@@ -63,33 +142,81 @@ class OrderBookSynchronizer
     void stop();
     void reset();
 
+    // Replay and tooling: installs the snapshot and applies events from it on, with no REST
+    // pipeline. A gap leaves the book buffering, since nothing fetches a new snapshot.
+    void startOffline(const DepthSnapshot &snapshot);
+
     // Event processing
-    void processDepthEvent(const std::string &jsonData);
+    void processDepthEvent(std::string_view jsonData);
+    void processDepthEvent(const DepthEvent &event);
+    DepthEvent parseDepthEvent(std::string_view jsonData) const;
+    // Refills a caller-owned event; allocation-free once its buffers have grown
+    bool parseDepthEvent(std::string_view jsonData, DepthEvent &event) const;
 
     // Data access
     OrderBookData getOrderBookSnapshot() const;
     std::pair<std::vector<OrderBookLevel>, std::vector<OrderBookLevel>> getTopLevels(int levels = 5) const;
+    void copyLevelWindow(LevelWindow &window) const;
+    void copyAggregatedWindow(size_t ticks, LevelWindow &window) const;
+
+    // Liquidity queries; O(log n) under the book lock when a depth index is set and usable
+    FillEstimate estimateFill(bool bidSide, double quantity) const;
+    DepthSum depthWithinBps(bool bidSide, double bps) const;
 
     // Status
     bool isInitialized() const;
     bool isSynchronized() const;
+    bool isStale() const;
     SyncState getState() const;
     std::string getStateString() const;
+    const SyncMetrics &getMetrics() const;
+    long long getLocalUpdateId() const;
 
     // Configuration
     void setUpdateCallback(const std::function<void()> &callback);
+    void setJournal(BookJournal *bookJournal);
+    void setDepthHistory(DepthHistory *history);
+    void setCheckpointPath(const std::string &path);
+    void setDepthBound(const DepthBound &bound);
+    void addAggregationView(size_t ticks);
+    void setDepthIndex(size_t ticks);
+    void setAnalyticsSlot(AnalyticsTable *table, size_t slot);
+    void setViewSlot(BookViewTable *table, size_t slot);
+    // 0 disables the audit; without repair a divergence is only logged and counted
+    void setAuditInterval(std::chrono::seconds interval, bool repair = true);
+
+    // Level change subscriptions; callbacks run on the hub's dispatcher thread, polled
+    // subscriptions are drained by the caller. Neither can stall the applying thread.
+    SubscriptionHandle subscribe(const SubscriptionFilter &filter, std::function<void(const LevelChange &)> callback);
+    SubscriptionHandle subscribe(const SubscriptionFilter &filter);
+    void unsubscribe(const SubscriptionHandle &subscription);
 
   private:
     // Binance protocol implementation
+    DetachedTask runPipeline();
     void processEventBuffer();
-    void requestSnapshot();
-    void handleSnapshotReceived(const DepthSnapshot &snapshot);
+    int getSnapshotLimit() const;
+    int getSnapshotLimitLocked() const; // Caller holds orderBookMutex
+    bool handleSnapshotReceived(const DepthSnapshot &snapshot, bool shallow); // False when stale
+    template <typename Result> std::shared_ptr<PendingFetch<Result>> beginFetch();
+    bool mergeBackfill(const DepthSnapshot &deep);
     void applyDepthEvent(const DepthEvent &event);
+    void enforceDepthBound(int64_t journalTime, long long updateId); // Caller holds orderBookMutex
+    void captureHorizons(const std::vector<size_t> &depths, bool before);
+    void publishChanges(const LevelChangeHub::SubscriberList &list, const TopOfBook &before, const TopOfBook &after);
+    void publishBookReplaced(int64_t timeNs);
     bool validateEventSequence(const DepthEvent &event) const;
-    void backgroundProcessor();
 
-    // Event parsing
-    DepthEvent parseDepthEvent(const std::string &jsonData) const;
+    // Drift audit
+    bool isAuditDue() const;
+    void beginAudit(long long &startId);
+    void finishAudit(DepthSnapshot &reference, long long startId);
+    void endAudit();
+    void recordAuditDelta(long long updateId, BookSide side, double price, double quantity); // Under the lock
+
+    // Warm start
+    void loadWarmCheckpoint();
+    void saveCheckpointIfDue();
 
     // Buffer management
     void bufferEvent(const DepthEvent &event);
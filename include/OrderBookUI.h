@@ -1,7 +1,16 @@
 #pragma once
 #include "AveragePrice.h"
+#include "DepthHistory.h"
+#include "FeedArbiter.h"
+#include "OrderBookData.h"
+#include <array>
+#include <chrono>
+#include <ftxui/component/event.hpp>
 #include <ftxui/component/screen_interactive.hpp>
+#include <ftxui/dom/elements.hpp>
+#include <functional>
 #include <string>
+#include <vector>
 
 // Forward declaration
 class OrderBookManager;
@@ -9,10 +18,67 @@ class OrderBookManager;
 class OrderBookUI
 {
   private:
+    static constexpr size_t ROW_BUFFER_SIZE = 64;
+
+    // One displayed level. The text and element are rebuilt only when the level changes.
+    struct LadderRow
+    {
+        double price = -1.0;
+        double quantity = -1.0;
+        std::array<char, ROW_BUFFER_SIZE> buffer{};
+        size_t length = 0;
+        ftxui::Element element;
+    };
+
     AveragePrice &avgPrice;
     OrderBookManager &orderBookManager;
-    std::string symbol;
+    std::string symbol; // Upper-cased once for display
     ftxui::ScreenInteractive screen;
+    std::function<std::vector<FeedConnectionStats>()> feedStatsProvider;
+
+    // Render state, only touched on the UI thread
+    LevelWindow window;
+    std::vector<LadderRow> bidRows;
+    std::vector<LadderRow> askRows;
+
+    double lastMidPrice = -1.0;
+    PriceChange lastPriceChange = CONSTANT;
+    ftxui::Element midPriceElement;
+
+    ftxui::Elements feedElements;
+    std::chrono::steady_clock::time_point lastFeedRefresh;
+
+    // Deep ladder view: scrollable, renders only the rows that fit on screen. The scroll position
+    // lives in `window` as the price of each side's first row.
+    bool ladderMode = false;
+
+    // Zoom: 1 tick shows raw levels, coarser levels read the book's aggregation views
+    size_t zoomIndex = 0;
+
+    // Heatmap view: liquidity by price over the recent past, read from the book's depth history
+    const DepthHistory *depthHistory = nullptr;
+    bool heatmapMode = false;
+    HeatmapGrid heatmap;
+
+    // Configuration
+    static constexpr size_t TOP_LEVELS = 5;
+    static constexpr int LADDER_CHROME_ROWS = 11; // Title, zoom, mid price, separators, footer, border
+    static constexpr int FEED_REFRESH_MS = 1000;
+    static constexpr int HEATMAP_CHROME_ROWS = 7; // Title, time axis, separators, footer, border
+    static constexpr int HEATMAP_LABEL_WIDTH = 12;
+    static constexpr size_t HEATMAP_MAX_COLUMNS = 240;
+    static constexpr int64_t HEATMAP_MAX_SECONDS = 300;
+
+    size_t getVisibleRows() const;
+    void scrollToTop();
+    void resizeRows(size_t rows);
+    void refreshRows(std::vector<LadderRow> &rows, const std::vector<OrderBookLevel> &levels, size_t count,
+                     ftxui::Color rowColor);
+    void refreshMidPrice();
+    void refreshFeedStats();
+    void renderHeatmap(ftxui::Elements &elements);
+    ftxui::Element render();
+    bool handleEvent(const ftxui::Event &event);
 
   public:
     OrderBookUI(AveragePrice &avgPrice, OrderBookManager &orderBookManager, const std::string &ticker);
@@ -20,4 +86,10 @@ class OrderBookUI
 
     void start();
     void stop();
+
+    void setFeedStatsProvider(const std::function<std::vector<FeedConnectionStats>()> &provider);
+    void setDepthHistory(const DepthHistory *history); // Enables the heatmap view
+
+    // Zoom levels in ticks; the owner registers an aggregation view for each one above 1
+    static constexpr std::array<size_t, 3> ZOOM_TICKS = {1, 10, 100};
 };
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <websocketpp/config/asio_client.hpp>
+#include <websocketpp/message_buffer/message.hpp>
+
+// Connection message manager that hands out messages from a fixed pool of
+// preallocated frame buffers instead of allocating a message and payload per frame.
+// A slot is free again once the pool holds the only reference to it, so websocketpp
+// releasing its message_ptr is all it takes to recycle the buffer.
+template <typename message> class PooledMessageManager
+    : public websocketpp::lib::enable_shared_from_this<PooledMessageManager<message>>
+{
+  public:
+    typedef PooledMessageManager<message> type;
+    typedef websocketpp::lib::shared_ptr<PooledMessageManager> ptr;
+    typedef websocketpp::lib::weak_ptr<PooledMessageManager> weak_ptr;
+    typedef typename message::ptr message_ptr;
+
+    static constexpr size_t POOL_SIZE = 8;
+    static constexpr size_t FRAME_BUFFER_CAPACITY = 64 * 1024;
+
+    message_ptr get_message()
+    {
+        return get_message(websocketpp::frame::opcode::text, 0);
+    }
+
+    message_ptr get_message(websocketpp::frame::opcode::value op, size_t size)
+    {
+        if (!poolReady)
+        {
+            fillPool();
+        }
+
+        for (size_t i = 0; i < POOL_SIZE; ++i)
+        {
+            message_ptr &slot = pool[(nextSlot + i) % POOL_SIZE];
+            if (slot.use_count() != 1)
+            {
+                continue;
+            }
+
+            // Pair with the release of the last outside reference before reusing the buffer
+            std::atomic_thread_fence(std::memory_order_acquire);
+            nextSlot = (nextSlot + i + 1) % POOL_SIZE;
+
+            slot->set_opcode(op);
+            slot->set_fin(true);
+            slot->set_terminal(false);
+            slot->set_compressed(false);
+            slot->set_prepared(false);
+            slot->set_header("");
+
+            // clear() keeps the capacity, so reserve only grows the buffer for oversized frames
+            std::string &payload = slot->get_raw_payload();
+            payload.clear();
+            payload.reserve(size);
+            return slot;
+        }
+
+        // Every slot is in flight; fall back to a one-off message rather than stalling the reader
+        return websocketpp::lib::make_shared<message>(type::shared_from_this(), op, size);
+    }
+
+    bool recycle(message *)
+    {
+        // Pooled slots come back automatically when their last outside reference is dropped
+        return true;
+    }
+
+  private:
+    std::array<message_ptr, POOL_SIZE> pool;
+    size_t nextSlot = 0;
+    bool poolReady = false;
+
+    void fillPool()
+    {
+        for (auto &slot : pool)
+        {
+            slot = websocketpp::lib::make_shared<message>(type::shared_from_this(), websocketpp::frame::opcode::text,
+                                                          FRAME_BUFFER_CAPACITY);
+        }
+        poolReady = true;
+    }
+};
+
+template <typename con_msg_manager> class PooledEndpointMsgManager
+{
+  public:
+    typedef typename con_msg_manager::ptr con_msg_man_ptr;
+
+    con_msg_man_ptr get_manager() const
+    {
+        return con_msg_man_ptr(websocketpp::lib::make_shared<con_msg_manager>());
+    }
+};
+
+// asio TLS client config with the pooled message manager swapped in
+struct PooledTlsClientConfig : public websocketpp::config::asio_tls_client
+{
+    typedef PooledTlsClientConfig type;
+
+    typedef websocketpp::message_buffer::message<PooledMessageManager> message_type;
+    typedef PooledMessageManager<message_type> con_msg_manager_type;
+    typedef PooledEndpointMsgManager<con_msg_manager_type> endpoint_msg_manager_type;
+};
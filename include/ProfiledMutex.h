@@ -0,0 +1,117 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+
+// Named mutex for the shared book, buffer and price locks.
+// Build with -DORDERBOOK_LOCK_PROFILING=ON to record, per lock name, histograms of how long
+// threads waited to acquire it and how long they held it, plus the call site of the longest hold.
+// With profiling off ProfiledMutex is a plain std::mutex and ProfiledLock a plain lock_guard.
+
+#ifdef ORDERBOOK_LOCK_PROFILING
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <ostream>
+
+// Wait/hold statistics shared by every mutex with the same name
+struct LockStats
+{
+    // Bucket i counts durations in [2^i, 2^(i+1)) ns; bucket 0 also takes zero
+    static constexpr size_t BUCKETS = 40;
+
+    std::string name;
+
+    std::atomic<uint64_t> acquisitions{0};
+    std::atomic<uint64_t> contended{0};
+    std::atomic<uint64_t> waitTotalNs{0};
+    std::atomic<uint64_t> holdTotalNs{0};
+    std::array<std::atomic<uint64_t>, BUCKETS> waitHistogram{};
+    std::array<std::atomic<uint64_t>, BUCKETS> holdHistogram{};
+
+    // Longest hold and where it was taken; updated only when beaten
+    std::atomic<uint64_t> maxHoldNs{0};
+    std::mutex maxHoldMutex;
+    const char *maxHoldFile = "";
+    int maxHoldLine = 0;
+
+    void recordWait(uint64_t waitNs);
+    void recordHold(uint64_t holdNs, const char *file, int line);
+};
+
+class LockProfiler
+{
+  private:
+    std::mutex registryMutex;
+    std::map<std::string, std::unique_ptr<LockStats>> locks;
+
+    LockProfiler() = default;
+
+  public:
+    static LockProfiler &instance();
+
+    LockStats &getStats(const std::string &name);
+
+    // Plain-text table of every lock's percentiles and worst call site
+    void writeReport(std::ostream &out);
+};
+
+class ProfiledMutex
+{
+  private:
+    std::mutex mutex;
+    LockStats &stats;
+
+    // Written only by the owning thread
+    uint64_t acquiredNs = 0;
+    const char *ownerFile = "";
+    int ownerLine = 0;
+
+  public:
+    explicit ProfiledMutex(const char *name);
+    ProfiledMutex(const ProfiledMutex &) = delete;
+    ProfiledMutex &operator=(const ProfiledMutex &) = delete;
+
+    void lock(const char *file = __builtin_FILE(), int line = __builtin_LINE());
+    void unlock();
+    bool try_lock();
+};
+
+// Scoped lock that records the caller's file and line as the holding site
+class ProfiledLock
+{
+  private:
+    ProfiledMutex &mutex;
+
+  public:
+    explicit ProfiledLock(ProfiledMutex &m, const char *file = __builtin_FILE(), int line = __builtin_LINE())
+        : mutex(m)
+    {
+        mutex.lock(file, line);
+    }
+
+    ~ProfiledLock()
+    {
+        mutex.unlock();
+    }
+
+    ProfiledLock(const ProfiledLock &) = delete;
+    ProfiledLock &operator=(const ProfiledLock &) = delete;
+};
+
+#else
+
+class ProfiledMutex : public std::mutex
+{
+  public:
+    explicit ProfiledMutex(const char *)
+    {
+    }
+};
+
+using ProfiledLock = std::lock_guard<ProfiledMutex>;
+
+#endif
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Bounded single-producer single-consumer ring. Both ends are wait-free: a full ring rejects
+// the push instead of blocking the producer. Capacity is rounded up to a power of two.
+template <typename T> class SpscRing
+{
+  private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    std::unique_ptr<T[]> slots;
+    size_t mask;
+
+    // Each index is written by one side only; keep them on separate lines
+    alignas(CACHE_LINE) std::atomic<size_t> head{0}; // Next slot to read
+    alignas(CACHE_LINE) std::atomic<size_t> tail{0}; // Next slot to write
+
+    static size_t roundUp(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        return size;
+    }
+
+  public:
+    explicit SpscRing(size_t capacity) : slots(std::make_unique<T[]>(roundUp(capacity))), mask(roundUp(capacity) - 1)
+    {
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    // Producer side
+    bool tryPush(const T &value)
+    {
+        size_t position = tail.load(std::memory_order_relaxed);
+        if (position - head.load(std::memory_order_acquire) > mask)
+        {
+            return false;
+        }
+        slots[position & mask] = value;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool tryPop(T &value)
+    {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position == tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        value = slots[position & mask];
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const
+    {
+        return mask + 1;
+    }
+};
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Shared executor for the per-symbol sync pipelines. A few worker threads resume
+// suspended coroutines and fire timers, so an idle pipeline costs a coroutine frame
+// rather than a thread, and nothing polls.
+class SyncExecutor
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    static SyncExecutor &instance();
+
+    // Resume a coroutine (or run a callback) on a worker thread
+    void post(std::coroutine_handle<> handle);
+    void post(std::function<void()> task);
+
+    // Run a callback on a worker thread once the deadline has passed
+    void postAt(Clock::time_point deadline, std::function<void()> task);
+
+    // co_await executor.schedule() moves the coroutine onto a worker thread
+    auto schedule()
+    {
+        struct Awaiter
+        {
+            SyncExecutor &executor;
+
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                executor.post(handle);
+            }
+            void await_resume() const noexcept
+            {
+            }
+        };
+        return Awaiter{*this};
+    }
+
+  private:
+    struct Timer
+    {
+        Clock::time_point deadline;
+        uint64_t sequence; // Keeps equal deadlines in submission order
+        std::function<void()> task;
+
+        bool operator>(const Timer &other) const
+        {
+            return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+        }
+    };
+
+    std::deque<std::function<void()>> ready;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    uint64_t timerSequence = 0;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+
+    std::vector<std::thread> workers;
+    bool running = true;
+
+    // Configuration
+    static constexpr size_t WORKER_THREADS = 2;
+
+    SyncExecutor();
+    ~SyncExecutor();
+    SyncExecutor(const SyncExecutor &) = delete;
+    SyncExecutor &operator=(const SyncExecutor &) = delete;
+
+    void workerLoop();
+};
+
+// Fire-and-forget coroutine; it starts eagerly and frees its frame when it finishes
+struct DetachedTask
+{
+    struct promise_type
+    {
+        DetachedTask get_return_object() noexcept
+        {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_void() noexcept
+        {
+        }
+        void unhandled_exception() noexcept
+        {
+            std::terminate();
+        }
+    };
+};
+
+// Wake-up signal for a single waiting coroutine. A notify with nobody waiting is
+// remembered, so the next wait completes at once.
+class AsyncSignal
+{
+  private:
+    struct State
+    {
+        std::mutex mutex;
+        std::coroutine_handle<> waiter;
+        uint64_t waitId = 0;
+        bool pending = false;
+    };
+
+    // Shared with timeout timers, which may fire after the signal is gone
+    std::shared_ptr<State> state = std::make_shared<State>();
+
+  public:
+    void notify();
+
+    // co_await signal.waitFor(timeout); true when notified, false on timeout
+    auto waitFor(SyncExecutor::Clock::duration timeout)
+    {
+        struct Awaiter
+        {
+            std::shared_ptr<State> state;
+            SyncExecutor::Clock::duration timeout;
+            bool notified = true;
+
+            bool await_ready()
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (state->pending)
+                {
+                    state->pending = false;
+                    return true;
+                }
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                uint64_t waitId;
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if (state->pending)
+                    {
+                        state->pending = false;
+                        return false;
+                    }
+                    state->waiter = handle;
+                    waitId = ++state->waitId;
+                }
+
+                SyncExecutor::instance().postAt(SyncExecutor::Clock::now() + timeout,
+                                                [state = state, waitId, this]() {
+                                                    std::coroutine_handle<> expired;
+                                                    {
+                                                        std::lock_guard<std::mutex> lock(state->mutex);
+                                                        if (!state->waiter || state->waitId != waitId)
+                                                        {
+                                                            return; // Already notified
+                                                        }
+                                                        expired = std::exchange(state->waiter, nullptr);
+                                                        notified = false;
+                                                    }
+                                                    expired.resume();
+                                                });
+                return true;
+            }
+
+            bool await_resume() const noexcept
+            {
+                return notified;
+            }
+        };
+        return Awaiter{state, timeout};
+    }
+};
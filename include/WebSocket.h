@@ -1,46 +1,131 @@
 #pragma once
 #include "AveragePrice.h"
+#include "FeedArbiter.h"
+#include "PooledMessageConfig.h"
 #include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 #include <websocketpp/client.hpp>
 #include <websocketpp/close.hpp>
 #include <websocketpp/common/connection_hdl.hpp>
 #include <websocketpp/config/asio_client.hpp>
 
-class OrderBookManager;
 class OrderBookSynchronizer;
 
-typedef websocketpp::client<websocketpp::config::asio_tls_client> client;
+typedef websocketpp::client<PooledTlsClientConfig> client;
 typedef websocketpp::lib::shared_ptr<websocketpp::lib::asio::ssl::context> context_ptr;
 
+// Feed handler multiplexing many symbols and stream types over a small pool of combined-stream
+// connections. Each group of streams is carried by several redundant connections (replicas).
 class WebSocket
 {
+  public:
+    // Receives the raw combined-stream frame and the replica it arrived on
+    using StreamHandler = std::function<void(size_t replica, std::string_view payload)>;
+
   private:
+    struct StreamRoute
+    {
+        std::string name; // e.g. "btcusdt@depth"
+        size_t group = 0;
+        StreamHandler handler;
+        std::unique_ptr<FeedArbiter> arbiter; // Depth streams only
+    };
+
+    struct ConnectionSlot
+    {
+        size_t group = 0;
+        size_t replica = 0;
+        websocketpp::connection_hdl hdl;
+        std::string uri; // Streams the current connection was opened with
+        bool open = false;
+    };
+
+    // Streams a group carries, and subscription changes waiting for the next control flush
+    struct StreamGroup
+    {
+        size_t streams = 0;
+        std::vector<std::string> pendingSubscribe;
+        std::vector<std::string> pendingUnsubscribe;
+    };
+
     client ws_client;
-    websocketpp::connection_hdl hdl;
-    std::string baseUri{"wss://stream.binance.com:9443/ws/"};
-    std::string symbol;
+    std::string endpoint{"wss://stream.binance.com:9443/stream"};
     std::thread ws_thread;
     std::atomic<bool> running;
-    AveragePrice &avgPrice;
-    OrderBookManager &orderBookManager;
-    OrderBookSynchronizer &synchronizer;
-
-    void on_message(client::message_ptr msg);
-    void on_open(websocketpp::connection_hdl hdl);
-    void on_close();
-    void on_fail();
-    context_ptr on_tls_init(websocketpp::connection_hdl hdl);
+    size_t replicas;
+
+    // Stream name -> route, keyed by views into the route's own name. Once started, only the
+    // WebSocket thread changes these, so on_message reads them without a lock; routeMutex covers
+    // readers on other threads.
+    std::vector<std::unique_ptr<StreamRoute>> routes;
+    std::unordered_map<std::string_view, StreamRoute *> routeTable;
+    mutable std::mutex routeMutex;
+
+    std::vector<StreamGroup> groups;
+    std::vector<ConnectionSlot> slots;
+    std::mutex slotMutex;
+    bool flushScheduled = false;
+    long long nextRequestId = 1;
 
-    // Helper methods
-    void updateMidPrice();
+    // Configuration
+    static constexpr size_t DEFAULT_FEED_CONNECTIONS = 2;
+    static constexpr size_t STREAMS_PER_CONNECTION = 200; // Binance allows 1024; keeps the URI short
+    static constexpr long RECONNECT_DELAY_MS = 1000;
+    static constexpr long CONTROL_FLUSH_MS = 500; // At most two control messages per flush; Binance allows 5/s
+    static constexpr long FEED_TASK_POLL_MS = 100; // How often a caller of runOnFeedThread checks the loop still runs
+
+    void addRoute(std::unique_ptr<StreamRoute> route);
+    bool removeRoute(const std::string &stream);
+    size_t assignGroup();
+    void openGroup(size_t group);
+    std::string groupUri(size_t group) const;
+    std::vector<std::string> groupStreams(size_t group) const;
+    static std::vector<std::string> uriStreams(const std::string &uri);
+    void runOnFeedThread(const std::function<void()> &task);
+
+    // SUBSCRIBE/UNSUBSCRIBE on the live connections, batched per group
+    void queueControl(size_t group, const std::string &stream, bool subscribe);
+    void flushControl();
+    void sendControl(websocketpp::connection_hdl hdl, const char *method, const std::vector<std::string> &streams);
+    static std::string_view extractStreamName(std::string_view payload);
+    static std::string normalizeSymbol(const std::string &symbol);
+
+    void connect(size_t slotIndex);
+    void scheduleReconnect(size_t slotIndex);
+    void setReplicaConnected(size_t slotIndex, bool connected);
+
+    void on_message(size_t slotIndex, client::message_ptr msg);
+    void on_open(size_t slotIndex, websocketpp::connection_hdl hdl);
+    void on_close(size_t slotIndex);
+    void on_fail(size_t slotIndex);
+    context_ptr on_tls_init(websocketpp::connection_hdl hdl);
 
   public:
-    WebSocket(AveragePrice &avgPrice, OrderBookManager &orderBookManager, OrderBookSynchronizer &synchronizer,
-              const std::string &tradingSymbol);
+    explicit WebSocket(size_t feedConnections = DEFAULT_FEED_CONNECTIONS);
     ~WebSocket();
 
+    // Stream registration, before or after start(). Once running, a new stream is subscribed on
+    // the open connections of a group with room, or a new group of connections is opened for it;
+    // the other streams are not disturbed. Not to be called from a stream handler.
+    void addStream(const std::string &stream, StreamHandler handler);
+    void addDepthStream(const std::string &symbol, OrderBookSynchronizer &synchronizer);
+    void addBookTickerStream(const std::string &symbol, AveragePrice &avgPrice);
+
+    // Unsubscribes the stream. On return its handler has finished and will not run again, so
+    // whatever it refers to can be torn down. False if no such stream was added.
+    bool removeStream(const std::string &stream);
+    void removeSymbol(const std::string &symbol); // Its depth and bookTicker streams
+
     void start();
     void stop();
+
+    // Per-replica arbitration results for a symbol's depth stream
+    std::vector<FeedConnectionStats> getFeedStats(const std::string &symbol) const;
 };
@@ -1,10 +1,5 @@
 #pragma once
-#include <map>
-
-// Bids: highest to lowest (reverse order)
-// Asks: lowest to highest (normal order)
-using BidsMap = std::map<double, double, std::greater<double>>;
-using AsksMap = std::map<double, double>;
+#include "OrderBookData.h" // BidsMap, AsksMap
 
 enum PriceChange
 {
@@ -0,0 +1,273 @@
+#include "AllocationTracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+constexpr size_t STAGE_COUNT = static_cast<size_t>(AllocationStage::COUNT);
+
+struct Counters
+{
+    std::array<std::atomic<uint64_t>, STAGE_COUNT> allocations{};
+    std::array<std::atomic<uint64_t>, STAGE_COUNT> bytes{};
+    std::atomic<uint64_t> frees{0};
+    std::atomic<uint64_t> messages{0};
+    std::atomic<uint64_t> messagesWithAllocations{0};
+    std::atomic<uint64_t> maxAllocationsPerMessage{0};
+};
+
+// Constant-initialized, so operator new can use them before main and after static teardown
+constinit Counters counters;
+
+// Trivial thread_locals need no TLS constructor, which operator new must not trigger
+constinit thread_local AllocationStage currentStage = AllocationStage::OTHER;
+constinit thread_local uint64_t threadAllocations = 0;
+constinit thread_local int messageDepth = 0;
+} // namespace
+
+const char *allocationStageName(AllocationStage stage)
+{
+    switch (stage)
+    {
+    case AllocationStage::OTHER:
+        return "other";
+    case AllocationStage::PARSE:
+        return "parse";
+    case AllocationStage::SEQUENCE:
+        return "sequence";
+    case AllocationStage::APPLY:
+        return "apply";
+    case AllocationStage::PUBLISH:
+        return "publish";
+    case AllocationStage::COUNT:
+        break;
+    }
+    return "?";
+}
+
+AllocationStats AllocationTracker::snapshot()
+{
+    AllocationStats stats;
+    for (size_t i = 0; i < STAGE_COUNT; ++i)
+    {
+        stats.stages[i].allocations = counters.allocations[i].load(std::memory_order_relaxed);
+        stats.stages[i].bytes = counters.bytes[i].load(std::memory_order_relaxed);
+    }
+    stats.messages = counters.messages.load(std::memory_order_relaxed);
+    stats.messagesWithAllocations = counters.messagesWithAllocations.load(std::memory_order_relaxed);
+    stats.maxAllocationsPerMessage = counters.maxAllocationsPerMessage.load(std::memory_order_relaxed);
+    stats.frees = counters.frees.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void AllocationTracker::reset()
+{
+    for (size_t i = 0; i < STAGE_COUNT; ++i)
+    {
+        counters.allocations[i].store(0, std::memory_order_relaxed);
+        counters.bytes[i].store(0, std::memory_order_relaxed);
+    }
+    counters.messages.store(0, std::memory_order_relaxed);
+    counters.messagesWithAllocations.store(0, std::memory_order_relaxed);
+    counters.maxAllocationsPerMessage.store(0, std::memory_order_relaxed);
+    counters.frees.store(0, std::memory_order_relaxed);
+}
+
+void AllocationTracker::record(size_t bytes)
+{
+    size_t stage = static_cast<size_t>(currentStage);
+    counters.allocations[stage].fetch_add(1, std::memory_order_relaxed);
+    counters.bytes[stage].fetch_add(bytes, std::memory_order_relaxed);
+    threadAllocations++;
+}
+
+void AllocationTracker::recordFree()
+{
+    counters.frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+AllocationStageScope::AllocationStageScope(AllocationStage stage) : previous(currentStage)
+{
+    currentStage = stage;
+}
+
+AllocationStageScope::~AllocationStageScope()
+{
+    currentStage = previous;
+}
+
+AllocationMessageScope::AllocationMessageScope() : startAllocations(threadAllocations), outermost(messageDepth++ == 0)
+{
+}
+
+AllocationMessageScope::~AllocationMessageScope()
+{
+    messageDepth--;
+    if (!outermost)
+    {
+        return;
+    }
+
+    uint64_t allocated = threadAllocations - startAllocations;
+    counters.messages.fetch_add(1, std::memory_order_relaxed);
+    if (allocated == 0)
+    {
+        return;
+    }
+
+    counters.messagesWithAllocations.fetch_add(1, std::memory_order_relaxed);
+    uint64_t worst = counters.maxAllocationsPerMessage.load(std::memory_order_relaxed);
+    while (allocated > worst &&
+           !counters.maxAllocationsPerMessage.compare_exchange_weak(worst, allocated, std::memory_order_relaxed))
+    {
+    }
+}
+
+#ifdef ORDERBOOK_ALLOC_TRACKING
+
+// Counting replacements for every global allocation function. They sit on malloc directly so
+// nothing here allocates through operator new again.
+namespace
+{
+void *trackedAllocate(size_t size)
+{
+    void *pointer = std::malloc(size ? size : 1);
+    if (pointer)
+    {
+        AllocationTracker::record(size);
+    }
+    return pointer;
+}
+
+void *trackedAllocateAligned(size_t size, std::align_val_t alignment)
+{
+    size_t align = static_cast<size_t>(alignment);
+    size_t rounded = (size + align - 1) / align * align;
+    void *pointer = std::aligned_alloc(align, rounded ? rounded : align);
+    if (pointer)
+    {
+        AllocationTracker::record(size);
+    }
+    return pointer;
+}
+
+void trackedFree(void *pointer)
+{
+    if (pointer)
+    {
+        AllocationTracker::recordFree();
+        std::free(pointer);
+    }
+}
+} // namespace
+
+void *operator new(size_t size)
+{
+    if (void *pointer = trackedAllocate(size))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    if (void *pointer = trackedAllocate(size))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    if (void *pointer = trackedAllocateAligned(size, alignment))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+    if (void *pointer = trackedAllocateAligned(size, alignment))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return trackedAllocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return trackedAllocate(size);
+}
+
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return trackedAllocateAligned(size, alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return trackedAllocateAligned(size, alignment);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    trackedFree(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    trackedFree(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+    trackedFree(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept
+{
+    trackedFree(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept
+{
+    trackedFree(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t) noexcept
+{
+    trackedFree(pointer);
+}
+
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept
+{
+    trackedFree(pointer);
+}
+
+void operator delete[](void *pointer, size_t, std::align_val_t) noexcept
+{
+    trackedFree(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept
+{
+    trackedFree(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept
+{
+    trackedFree(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    trackedFree(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    trackedFree(pointer);
+}
+
+#endif
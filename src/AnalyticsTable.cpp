@@ -0,0 +1,211 @@
+#include "AnalyticsTable.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+constexpr double NOT_A_NUMBER = std::numeric_limits<double>::quiet_NaN();
+
+// Mean and standard deviation of the non-NaN entries. They are packed into scratch first, so the
+// sums run branch-free over four independent accumulators that map onto vector lanes.
+void meanAndDeviation(const double *values, size_t n, std::vector<double> &scratch, double &mean, double &deviation)
+{
+    scratch.clear();
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (values[i] == values[i])
+        {
+            scratch.push_back(values[i]);
+        }
+    }
+
+    const double *__restrict packed = scratch.data();
+    size_t count = scratch.size();
+    double sum[4] = {};
+    double squares[4] = {};
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        for (size_t lane = 0; lane < 4; ++lane)
+        {
+            sum[lane] += packed[i + lane];
+            squares[lane] += packed[i + lane] * packed[i + lane];
+        }
+    }
+    for (; i < count; ++i)
+    {
+        sum[0] += packed[i];
+        squares[0] += packed[i] * packed[i];
+    }
+
+    double total = sum[0] + sum[1] + sum[2] + sum[3];
+    double totalSquares = squares[0] + squares[1] + squares[2] + squares[3];
+
+    mean = count > 0 ? total / count : NOT_A_NUMBER;
+    double variance = count > 1 ? totalSquares / count - mean * mean : 0.0;
+    deviation = variance > 0.0 ? std::sqrt(variance) : 0.0;
+}
+
+// Empty sides are stored as NaN, so one-sided rows come out NaN without any masking and the
+// loop is plain arithmetic over non-aliasing columns, which the compiler vectorizes
+void topOfBookKernel(const double *__restrict bid, const double *__restrict bidQuantity, const double *__restrict ask,
+                     const double *__restrict askQuantity, double *__restrict mid, double *__restrict spread,
+                     double *__restrict spreadBps, double *__restrict microprice, double *__restrict imbalance,
+                     size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        double depth = bidQuantity[i] + askQuantity[i];
+        mid[i] = (bid[i] + ask[i]) * 0.5;
+        spread[i] = ask[i] - bid[i];
+        spreadBps[i] = spread[i] / mid[i] * 1e4;
+        microprice[i] = (bid[i] * askQuantity[i] + ask[i] * bidQuantity[i]) / depth;
+        imbalance[i] = (bidQuantity[i] - askQuantity[i]) / depth;
+    }
+}
+
+void zScores(const double *__restrict values, double *__restrict scores, size_t n, std::vector<double> &scratch)
+{
+    double mean;
+    double deviation;
+    meanAndDeviation(values, n, scratch, mean, deviation);
+
+    // A flat cross-section scores zero; NaN inputs stay NaN
+    double scale = deviation > 0.0 ? 1.0 / deviation : 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        scores[i] = (values[i] - mean) * scale;
+    }
+}
+} // namespace
+
+AnalyticsTable::AnalyticsTable(size_t maxSymbols)
+    : capacity(maxSymbols), sequences(std::make_unique<std::atomic<uint32_t>[]>(maxSymbols)),
+      bidPrices(std::make_unique<double[]>(maxSymbols)), bidQuantities(std::make_unique<double[]>(maxSymbols)),
+      askPrices(std::make_unique<double[]>(maxSymbols)), askQuantities(std::make_unique<double[]>(maxSymbols)),
+      updateIds(std::make_unique<long long[]>(maxSymbols))
+{
+    symbols.reserve(maxSymbols);
+}
+
+size_t AnalyticsTable::addSymbol(const std::string &symbol)
+{
+    std::lock_guard<std::mutex> lock(symbolsMutex);
+
+    auto existing = std::find(symbols.begin(), symbols.end(), symbol);
+    if (existing != symbols.end())
+    {
+        return existing - symbols.begin();
+    }
+    if (symbols.size() == capacity)
+    {
+        throw std::length_error("AnalyticsTable is full");
+    }
+
+    // No book yet
+    size_t slot = symbols.size();
+    bidPrices[slot] = bidQuantities[slot] = askPrices[slot] = askQuantities[slot] = NOT_A_NUMBER;
+
+    symbols.push_back(symbol);
+    rows.store(symbols.size(), std::memory_order_release);
+    return symbols.size() - 1;
+}
+
+void AnalyticsTable::update(size_t slot, const TopOfBook &top, long long updateId)
+{
+    // Odd while the row is being written
+    std::atomic<uint32_t> &sequence = sequences[slot];
+    uint32_t current = sequence.load(std::memory_order_relaxed);
+    sequence.store(current + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // An empty side is stored as NaN so it propagates through the kernels
+    bool hasBid = top.bidPrice > 0.0;
+    bool hasAsk = top.askPrice > 0.0;
+    std::atomic_ref<double>(bidPrices[slot]).store(hasBid ? top.bidPrice : NOT_A_NUMBER, std::memory_order_relaxed);
+    std::atomic_ref<double>(bidQuantities[slot]).store(hasBid ? top.bidQuantity : NOT_A_NUMBER,
+                                                       std::memory_order_relaxed);
+    std::atomic_ref<double>(askPrices[slot]).store(hasAsk ? top.askPrice : NOT_A_NUMBER, std::memory_order_relaxed);
+    std::atomic_ref<double>(askQuantities[slot]).store(hasAsk ? top.askQuantity : NOT_A_NUMBER,
+                                                       std::memory_order_relaxed);
+    std::atomic_ref<long long>(updateIds[slot]).store(updateId, std::memory_order_relaxed);
+
+    sequence.store(current + 2, std::memory_order_release);
+}
+
+void AnalyticsTable::compute(AnalyticsSnapshot &out) const
+{
+    size_t n = rows.load(std::memory_order_acquire);
+    out.size = n;
+    for (auto *column : {&out.bidPrice, &out.bidQuantity, &out.askPrice, &out.askQuantity, &out.mid, &out.spread,
+                         &out.spreadBps, &out.microprice, &out.imbalance, &out.imbalanceZ, &out.spreadBpsZ})
+    {
+        column->resize(n);
+    }
+    out.updateId.resize(n);
+    out.imbalanceRank.resize(n);
+
+    // Copy each row consistently; a row written meanwhile is read again
+    for (size_t slot = 0; slot < n; ++slot)
+    {
+        const std::atomic<uint32_t> &sequence = sequences[slot];
+        uint32_t before;
+        uint32_t after;
+        do
+        {
+            before = sequence.load(std::memory_order_acquire);
+            out.bidPrice[slot] = std::atomic_ref<double>(bidPrices[slot]).load(std::memory_order_relaxed);
+            out.bidQuantity[slot] = std::atomic_ref<double>(bidQuantities[slot]).load(std::memory_order_relaxed);
+            out.askPrice[slot] = std::atomic_ref<double>(askPrices[slot]).load(std::memory_order_relaxed);
+            out.askQuantity[slot] = std::atomic_ref<double>(askQuantities[slot]).load(std::memory_order_relaxed);
+            out.updateId[slot] = std::atomic_ref<long long>(updateIds[slot]).load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+    }
+
+    computeMetrics(out);
+    computeSignals(out);
+}
+
+void AnalyticsTable::computeMetrics(AnalyticsSnapshot &out)
+{
+    topOfBookKernel(out.bidPrice.data(), out.bidQuantity.data(), out.askPrice.data(), out.askQuantity.data(),
+                    out.mid.data(), out.spread.data(), out.spreadBps.data(), out.microprice.data(),
+                    out.imbalance.data(), out.size);
+}
+
+void AnalyticsTable::computeSignals(AnalyticsSnapshot &out)
+{
+    const size_t n = out.size;
+    zScores(out.imbalance.data(), out.imbalanceZ.data(), n, out.scratch);
+    zScores(out.spreadBps.data(), out.spreadBpsZ.data(), n, out.scratch);
+
+    // NaN rows sort last
+    std::iota(out.imbalanceRank.begin(), out.imbalanceRank.end(), 0u);
+    const std::vector<double> &imbalance = out.imbalance;
+    std::sort(out.imbalanceRank.begin(), out.imbalanceRank.end(), [&imbalance](uint32_t a, uint32_t b) {
+        bool aValid = imbalance[a] == imbalance[a];
+        bool bValid = imbalance[b] == imbalance[b];
+        if (aValid != bValid)
+        {
+            return aValid;
+        }
+        return aValid && imbalance[a] > imbalance[b];
+    });
+}
+
+size_t AnalyticsTable::size() const
+{
+    return rows.load(std::memory_order_acquire);
+}
+
+std::string AnalyticsTable::getSymbol(size_t slot) const
+{
+    std::lock_guard<std::mutex> lock(symbolsMutex);
+    return slot < symbols.size() ? symbols[slot] : std::string();
+}
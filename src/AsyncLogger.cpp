@@ -0,0 +1,260 @@
+#include "AsyncLogger.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+namespace
+{
+constexpr int64_t NS_PER_SECOND = 1000000000;
+
+const char *levelName(LogLevel level)
+{
+    switch (level)
+    {
+    case LogLevel::DEBUG:
+        return "DEBUG";
+    case LogLevel::INFO:
+        return "INFO ";
+    case LogLevel::WARN:
+        return "WARN ";
+    case LogLevel::ERROR:
+        return "ERROR";
+    }
+    return "?    ";
+}
+
+void appendTimestamp(std::string &line, int64_t timestampNs)
+{
+    std::time_t seconds = static_cast<std::time_t>(timestampNs / NS_PER_SECOND);
+    std::tm utc{};
+    gmtime_r(&seconds, &utc);
+
+    char buffer[40];
+    size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &utc);
+    length += std::snprintf(buffer + length, sizeof(buffer) - length, ".%06lld ",
+                            static_cast<long long>(timestampNs % NS_PER_SECOND / 1000));
+    line.append(buffer, length);
+}
+} // namespace
+
+AsyncLogger &AsyncLogger::instance()
+{
+    static AsyncLogger logger;
+    return logger;
+}
+
+AsyncLogger::AsyncLogger()
+{
+    line.reserve(256);
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    stop();
+}
+
+int64_t AsyncLogger::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+void AsyncLogger::start()
+{
+    if (running.exchange(true))
+    {
+        return;
+    }
+
+    const char *path = std::getenv("ORDERBOOK_LOG_FILE");
+    file.open(path ? path : DEFAULT_LOG_FILE, std::ios::app);
+    writer = std::thread(&AsyncLogger::writerLoop, this);
+}
+
+void AsyncLogger::stop()
+{
+    if (!running.exchange(false))
+    {
+        return;
+    }
+
+    if (writer.joinable())
+    {
+        writer.join();
+    }
+    file.close();
+}
+
+void AsyncLogger::setMinimumLevel(LogLevel level)
+{
+    minimumLevel.store(level);
+}
+
+AsyncLogger::ThreadBuffer &AsyncLogger::threadBuffer()
+{
+    // Registered once per thread; the logger keeps it alive after the thread exits so the
+    // writer can still drain it
+    thread_local ThreadBuffer *buffer = nullptr;
+    if (!buffer)
+    {
+        auto created = std::make_shared<ThreadBuffer>();
+        buffer = created.get();
+
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffers.push_back(std::move(created));
+    }
+    return *buffer;
+}
+
+void AsyncLogger::pack(LogRecord &record, LogArg &arg, std::string_view text)
+{
+    size_t length = std::min(text.size(), LogRecord::TEXT_CAPACITY - record.textUsed);
+    std::memcpy(record.text.data() + record.textUsed, text.data(), length);
+
+    arg.type = LogArg::Type::TEXT;
+    arg.text.offset = record.textUsed;
+    arg.text.length = static_cast<uint16_t>(length);
+    record.textUsed += static_cast<uint16_t>(length);
+}
+
+void AsyncLogger::writerLoop()
+{
+    while (running.load())
+    {
+        if (drain() == 0)
+        {
+            flushSuppressed(now(), false);
+            file.flush();
+            std::this_thread::sleep_for(std::chrono::milliseconds(WRITER_INTERVAL_MS));
+        }
+    }
+
+    // Final pass after stop
+    drain();
+    flushSuppressed(now(), true);
+    file.flush();
+}
+
+size_t AsyncLogger::drain()
+{
+    std::vector<std::shared_ptr<ThreadBuffer>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        snapshot = buffers;
+    }
+
+    // Records are written per thread; the timestamps order them across threads
+    size_t written = 0;
+    uint64_t drops = 0;
+    LogRecord record;
+    for (const auto &buffer : snapshot)
+    {
+        while (buffer->ring.tryPop(record))
+        {
+            write(record);
+            written++;
+        }
+        drops += buffer->dropped.load(std::memory_order_relaxed);
+    }
+
+    if (drops > reportedDrops)
+    {
+        line.clear();
+        appendTimestamp(line, now());
+        line += "WARN  logger: ";
+        line += std::to_string(drops - reportedDrops);
+        line += " records dropped, a thread ring was full\n";
+        file << line;
+        reportedDrops = drops;
+    }
+    return written;
+}
+
+void AsyncLogger::write(const LogRecord &record)
+{
+    SiteWindow &site = sites[record.format];
+    site.level = record.level;
+
+    if (record.timestampNs - site.windowStartNs >= NS_PER_SECOND)
+    {
+        flushSuppressed(record.timestampNs, false);
+        site.windowStartNs = record.timestampNs;
+        site.written = 0;
+    }
+
+    // A gap storm or error loop writes a few lines a second, then a count
+    if (site.written >= MAX_PER_SITE_PER_SECOND)
+    {
+        site.suppressed++;
+        return;
+    }
+    site.written++;
+
+    formatRecord(record);
+    file << line;
+}
+
+void AsyncLogger::flushSuppressed(int64_t nowNs, bool all)
+{
+    for (auto &[format, site] : sites)
+    {
+        if (site.suppressed == 0 || (!all && nowNs - site.windowStartNs < NS_PER_SECOND))
+        {
+            continue;
+        }
+
+        line.clear();
+        appendTimestamp(line, nowNs);
+        line += levelName(site.level);
+        line += " suppressed ";
+        line += std::to_string(site.suppressed);
+        line += " more: ";
+        line += format;
+        line += '\n';
+        file << line;
+        site.suppressed = 0;
+    }
+}
+
+void AsyncLogger::formatRecord(const LogRecord &record)
+{
+    line.clear();
+    appendTimestamp(line, record.timestampNs);
+    line += levelName(record.level);
+    line += ' ';
+
+    size_t argIndex = 0;
+    for (const char *c = record.format; *c; ++c)
+    {
+        if (c[0] == '{' && c[1] == '}' && argIndex < record.argCount)
+        {
+            const LogArg &arg = record.args[argIndex++];
+            char number[32];
+            switch (arg.type)
+            {
+            case LogArg::Type::INT:
+            {
+                auto result = std::to_chars(number, number + sizeof(number), arg.integer);
+                line.append(number, result.ptr);
+                break;
+            }
+            case LogArg::Type::DOUBLE:
+            {
+                auto result = std::to_chars(number, number + sizeof(number), arg.real);
+                line.append(number, result.ptr);
+                break;
+            }
+            case LogArg::Type::TEXT:
+                line.append(record.text.data() + arg.text.offset, arg.text.length);
+                break;
+            }
+            ++c;
+            continue;
+        }
+        line += *c;
+    }
+    line += '\n';
+}
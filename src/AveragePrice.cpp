@@ -8,7 +8,7 @@ AveragePrice::AveragePrice() : currPrice(0), prevPrice(0), priceChange(CONSTANT)
 
 void AveragePrice::updatePrice(const double updatePrice)
 {
-    std::lock_guard<std::mutex> lock(avgPriceMutex);
+    ProfiledLock lock(avgPriceMutex);
 
     prevPrice = currPrice;
     currPrice = updatePrice;
@@ -33,7 +33,7 @@ void AveragePrice::updatePrice(const double updatePrice)
 
 std::pair<double, PriceChange> AveragePrice::getCurrentPrice()
 {
-    std::lock_guard<std::mutex> lock(avgPriceMutex);
+    ProfiledLock lock(avgPriceMutex);
 
     return std::make_pair(currPrice, priceChange);
 }
@@ -0,0 +1,339 @@
+#include "BacktestEngine.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+// Quantities below this are treated as fully filled
+constexpr double QUANTITY_EPSILON = 1e-12;
+
+double slippageBps(const SimOrder &order)
+{
+    double averagePrice = order.fillNotional / order.filled;
+    double difference = order.side == SimSide::BUY ? averagePrice - order.arrivalMid : order.arrivalMid - averagePrice;
+    return difference / order.arrivalMid * 1e4;
+}
+} // namespace
+
+void BacktestEngine::addOrder(const SimOrderRequest &request)
+{
+    requests.push_back(request);
+}
+
+const std::vector<SimOrder> &BacktestEngine::getOrders() const
+{
+    return orders;
+}
+
+double BacktestEngine::getMid() const
+{
+    if (book.getBids().empty() || book.getAsks().empty())
+    {
+        return 0.0;
+    }
+    return (book.getBids().begin()->first + book.getAsks().begin()->first) / 2.0;
+}
+
+BacktestReport BacktestEngine::run(const BookJournalReader &reader)
+{
+    std::stable_sort(requests.begin(), requests.end(), [](const SimOrderRequest &a, const SimOrderRequest &b) {
+        return a.timestampNs < b.timestampNs;
+    });
+    orders.clear();
+    orders.reserve(requests.size());
+    restingBuys.clear();
+    restingSells.clear();
+
+    BacktestReport report;
+    size_t deltaCount = reader.getDeltaCount();
+    size_t checkpointCount = reader.getCheckpointCount();
+    if (checkpointCount == 0)
+    {
+        return report;
+    }
+
+    size_t nextCheckpoint = 0;
+    size_t nextRequest = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = reader.getCheckpoint(0).deltaOffset; i < deltaCount; ++i)
+    {
+        // A checkpoint whose id differs from the replayed book marks a resync; periodic ones match
+        while (nextCheckpoint < checkpointCount && reader.getCheckpoint(nextCheckpoint).deltaOffset == i)
+        {
+            const JournalIndexEntry &checkpoint = reader.getCheckpoint(nextCheckpoint++);
+            if (report.booksLoaded == 0 || checkpoint.updateId != book.getLastUpdateId())
+            {
+                reader.loadCheckpoint(checkpoint, book);
+                report.booksLoaded++;
+            }
+        }
+
+        JournalDelta delta = reader.getDelta(i);
+
+        while (nextRequest < requests.size() && requests[nextRequest].timestampNs <= delta.timestampNs)
+        {
+            submit(requests[nextRequest++]);
+        }
+
+        applyDelta(delta);
+        report.eventsReplayed++;
+    }
+
+    report.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    BacktestReport summary = summarize();
+    summary.eventsReplayed = report.eventsReplayed;
+    summary.booksLoaded = report.booksLoaded;
+    summary.elapsedSeconds = report.elapsedSeconds;
+    summary.eventsPerSecond = report.elapsedSeconds > 0.0 ? report.eventsReplayed / report.elapsedSeconds : 0.0;
+    return summary;
+}
+
+void BacktestEngine::submit(const SimOrderRequest &request)
+{
+    SimOrder order;
+    order.submittedNs = request.timestampNs;
+    order.side = request.side;
+    order.type = request.type;
+    order.quantity = request.quantity;
+    order.arrivalMid = getMid();
+    if (order.arrivalMid == 0.0 || request.quantity <= 0.0)
+    {
+        return; // No two-sided book to trade against
+    }
+
+    bool isBuy = request.side == SimSide::BUY;
+    if (request.type == SimOrderType::MARKET)
+    {
+        order.price = isBuy ? book.getAsks().rbegin()->first : book.getBids().rbegin()->first;
+        takeLiquidity(order, order.price, request.timestampNs);
+        orders.push_back(order);
+        return;
+    }
+
+    // Round through the journal's fixed point so the price matches recorded levels exactly
+    order.price = std::llround(request.price * JOURNAL_FIXED_SCALE) / JOURNAL_FIXED_SCALE;
+    if (order.price <= 0.0)
+    {
+        order.price = isBuy ? book.getBids().begin()->first : book.getAsks().begin()->first;
+    }
+
+    // A marketable limit takes what it can up to its price; the recorded book can't show the
+    // levels it would have consumed, so the remainder is cancelled rather than rested
+    bool marketable =
+        isBuy ? order.price >= book.getAsks().begin()->first : order.price <= book.getBids().begin()->first;
+    if (marketable)
+    {
+        takeLiquidity(order, order.price, request.timestampNs);
+        orders.push_back(order);
+        return;
+    }
+
+    // Join the back of the displayed queue at our price
+    uint32_t index = static_cast<uint32_t>(orders.size());
+    if (isBuy)
+    {
+        auto level = book.getBids().find(order.price);
+        order.queueAhead = level != book.getBids().end() ? level->second : 0.0;
+        restingBuys[order.price].push_back(index);
+    }
+    else
+    {
+        auto level = book.getAsks().find(order.price);
+        order.queueAhead = level != book.getAsks().end() ? level->second : 0.0;
+        restingSells[order.price].push_back(index);
+    }
+    orders.push_back(order);
+}
+
+void BacktestEngine::takeLiquidity(SimOrder &order, double limitPrice, int64_t now)
+{
+    // Walk the opposite side without modifying it; the recorded stream already contains the real fills
+    auto walk = [&](const auto &levels, auto crosses) {
+        for (const auto &[price, quantity] : levels)
+        {
+            if (order.remaining() <= QUANTITY_EPSILON || !crosses(price))
+            {
+                break;
+            }
+            fill(order, std::min(order.remaining(), quantity), price, now);
+        }
+    };
+
+    if (order.side == SimSide::BUY)
+        walk(book.getAsks(), [limitPrice](double price) { return price <= limitPrice; });
+    else
+        walk(book.getBids(), [limitPrice](double price) { return price >= limitPrice; });
+}
+
+void BacktestEngine::fill(SimOrder &order, double quantity, double price, int64_t now)
+{
+    if (quantity <= 0.0)
+    {
+        return;
+    }
+
+    order.filled += quantity;
+    order.fillNotional += quantity * price;
+    order.lastFillNs = now;
+}
+
+void BacktestEngine::applyDelta(const JournalDelta &delta)
+{
+    // Resting orders only care about their own level, so most deltas skip the extra lookup
+    if (delta.side == JournalSide::BID)
+    {
+        if (!restingBuys.empty() && restingBuys.count(delta.price))
+        {
+            auto level = book.getBids().find(delta.price);
+            double previous = level != book.getBids().end() ? level->second : 0.0;
+            consumeQueue(restingBuys, delta.price, previous - delta.quantity, delta.timestampNs);
+        }
+        book.setBid(delta.price, delta.quantity);
+    }
+    else
+    {
+        if (!restingSells.empty() && restingSells.count(delta.price))
+        {
+            auto level = book.getAsks().find(delta.price);
+            double previous = level != book.getAsks().end() ? level->second : 0.0;
+            consumeQueue(restingSells, delta.price, previous - delta.quantity, delta.timestampNs);
+        }
+        book.setAsk(delta.price, delta.quantity);
+    }
+
+    book.setLastUpdateId(delta.updateId);
+    fillCrossedOrders(delta.timestampNs);
+}
+
+template <typename Levels>
+void BacktestEngine::consumeQueue(Levels &levels, double price, double decrease, int64_t now)
+{
+    if (decrease <= 0.0)
+    {
+        return; // Added quantity queues behind us
+    }
+
+    auto level = levels.find(price);
+    std::vector<uint32_t> &queue = level->second;
+
+    // Every order's queue shrinks by the decrease; what is left after its queue reaches zero fills it, in FIFO order
+    double tradedThrough = 0.0;
+    for (uint32_t index : queue)
+    {
+        SimOrder &order = orders[index];
+        double consumed = std::min(order.queueAhead, decrease);
+        order.queueAhead -= consumed;
+        tradedThrough = std::max(tradedThrough, decrease - consumed);
+    }
+
+    for (uint32_t index : queue)
+    {
+        if (tradedThrough <= QUANTITY_EPSILON)
+        {
+            break;
+        }
+        SimOrder &order = orders[index];
+        if (order.queueAhead > 0.0)
+        {
+            continue;
+        }
+        double quantity = std::min(order.remaining(), tradedThrough);
+        fill(order, quantity, price, now);
+        tradedThrough -= quantity;
+    }
+
+    queue.erase(std::remove_if(queue.begin(), queue.end(),
+                               [this](uint32_t index) { return orders[index].remaining() <= QUANTITY_EPSILON; }),
+                queue.end());
+    if (queue.empty())
+    {
+        levels.erase(level);
+    }
+}
+
+void BacktestEngine::fillCrossedOrders(int64_t now)
+{
+    // The opposite side moved through resting prices. Crossed orders take the levels at or through
+    // their price, best resting price first and FIFO within it, each level at its own price and
+    // shared so no displayed quantity fills twice. Like a marketable limit, the rest is cancelled.
+    auto sweep = [&](auto &resting, const auto &levels, auto crosses) {
+        auto level = levels.begin();
+        double taken = 0.0; // Quantity of the current level already given to earlier orders
+        while (!resting.empty() && !levels.empty() && crosses(levels.begin()->first, resting.begin()->first))
+        {
+            for (uint32_t index : resting.begin()->second)
+            {
+                SimOrder &order = orders[index];
+                while (order.remaining() > QUANTITY_EPSILON && level != levels.end() &&
+                       crosses(level->first, order.price))
+                {
+                    double quantity = std::min(order.remaining(), level->second - taken);
+                    fill(order, quantity, level->first, now);
+                    taken += quantity;
+                    if (level->second - taken <= QUANTITY_EPSILON)
+                    {
+                        ++level;
+                        taken = 0.0;
+                    }
+                }
+            }
+            resting.erase(resting.begin());
+        }
+    };
+
+    sweep(restingBuys, book.getAsks(), [](double ask, double buy) { return ask <= buy; });
+    sweep(restingSells, book.getBids(), [](double bid, double sell) { return bid >= sell; });
+}
+
+BacktestReport BacktestEngine::summarize() const
+{
+    BacktestReport report;
+    report.ordersSubmitted = orders.size();
+
+    double marketSlippage = 0.0;
+    double limitSlippage = 0.0;
+    double timeToFill = 0.0;
+    size_t marketFilled = 0;
+    size_t limitFilled = 0;
+
+    for (const SimOrder &order : orders)
+    {
+        if (order.filled <= QUANTITY_EPSILON)
+        {
+            report.ordersUnfilled++;
+            continue;
+        }
+
+        if (order.remaining() <= QUANTITY_EPSILON)
+            report.ordersFilled++;
+        else
+            report.ordersPartiallyFilled++;
+        report.filledQuantity += order.filled;
+
+        if (order.type == SimOrderType::MARKET)
+        {
+            marketSlippage += slippageBps(order);
+            marketFilled++;
+        }
+        else
+        {
+            limitSlippage += slippageBps(order);
+            timeToFill += (order.lastFillNs - order.submittedNs) / 1e6;
+            limitFilled++;
+        }
+    }
+
+    if (marketFilled > 0)
+    {
+        report.marketSlippageBps = marketSlippage / marketFilled;
+    }
+    if (limitFilled > 0)
+    {
+        report.limitSlippageBps = limitSlippage / limitFilled;
+        report.avgTimeToFillMs = timeToFill / limitFilled;
+    }
+    return report;
+}
@@ -1,54 +1,33 @@
 #include "BinanceAPI.h"
+#include "AsyncLogger.h"
+#include "HttpEngine.h"
 #include <algorithm>
 #include <cctype>
-#include <curl/curl.h>
-#include <iostream>
 #include <json/json.h>
-#include <thread>
+#include <memory>
 
-// Callback function to write HTTP response data
-static size_t WriteCallback(void *contents, size_t size, size_t nmemb, std::string *data)
+std::string BinanceAPI::upperCase(const std::string &symbol)
 {
-    size_t totalSize = size * nmemb;
-    data->append((char *)contents, totalSize);
-    return totalSize;
+    // Binance's REST API expects uppercase symbols
+    std::string upperSymbol = symbol;
+    std::transform(upperSymbol.begin(), upperSymbol.end(), upperSymbol.begin(), ::toupper);
+    return upperSymbol;
 }
 
 std::string BinanceAPI::buildSnapshotUrl(const std::string &symbol, int limit)
 {
-    // Convert symbol to uppercase for Binance API
-    std::string upperSymbol = symbol;
-    std::transform(upperSymbol.begin(), upperSymbol.end(), upperSymbol.begin(), ::toupper);
-    return "https://api.binance.com/api/v3/depth?symbol=" + upperSymbol + "&limit=" + std::to_string(limit);
+    return "https://api.binance.com/api/v3/depth?symbol=" + upperCase(symbol) + "&limit=" + std::to_string(limit);
 }
 
-std::string BinanceAPI::makeHttpRequest(const std::string &url)
+int BinanceAPI::getDepthRequestWeight(int limit)
 {
-    CURL *curl;
-    CURLcode res;
-    std::string response;
-
-    curl = curl_easy_init();
-    if (curl)
-    {
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L); // 10 second timeout
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L); // Skip SSL verification for simplicity
-
-        res = curl_easy_perform(curl);
-        curl_easy_cleanup(curl);
-
-        if (res != CURLE_OK)
-        {
-            std::cerr << "curl_easy_perform() failed: " << curl_easy_strerror(res) << std::endl;
-            return "";
-        }
-    }
-
-    return response;
+    if (limit <= 100)
+        return 5;
+    if (limit <= 500)
+        return 25;
+    if (limit <= 1000)
+        return 50;
+    return 250;
 }
 
 DepthSnapshot BinanceAPI::parseSnapshotResponse(const std::string &response)
@@ -62,22 +41,21 @@ DepthSnapshot BinanceAPI::parseSnapshotResponse(const std::string &response)
 
         if (!reader.parse(response, root))
         {
-            std::cerr << "Failed to parse JSON response" << std::endl;
+            LOG_ERROR("Failed to parse snapshot JSON response");
             return snapshot;
         }
 
         // Check for API error
         if (root.isMember("code") && root.isMember("msg"))
         {
-            std::cerr << "Binance API error: " << root["msg"].asString() << " (code: " << root["code"].asInt() << ")"
-                      << std::endl;
+            LOG_ERROR("Binance API error: {} (code: {})", root["msg"].asString(), root["code"].asInt());
             return snapshot;
         }
 
         // Parse lastUpdateId
         if (!root.isMember("lastUpdateId"))
         {
-            std::cerr << "Missing lastUpdateId in response" << std::endl;
+            LOG_ERROR("Missing lastUpdateId in snapshot response");
             return snapshot;
         }
         snapshot.lastUpdateId = root["lastUpdateId"].asInt64();
@@ -116,7 +94,7 @@ DepthSnapshot BinanceAPI::parseSnapshotResponse(const std::string &response)
     }
     catch (const std::exception &e)
     {
-        std::cerr << "Error parsing snapshot: " << e.what() << std::endl;
+        LOG_ERROR("Error parsing snapshot: {}", e.what());
         snapshot.isValid = false;
     }
 
@@ -125,19 +103,84 @@ DepthSnapshot BinanceAPI::parseSnapshotResponse(const std::string &response)
 
 DepthSnapshot BinanceAPI::getDepthSnapshot(const std::string &symbol, int limit)
 {
-    std::string url = buildSnapshotUrl(symbol, limit);
-
-    std::string response = makeHttpRequest(url);
-    if (response.empty())
+    // Only the engine thread can complete the request, so blocking it would never return
+    if (HttpEngine::instance().isEngineThread())
     {
-        std::cerr << "Empty response from Binance API" << std::endl;
+        LOG_ERROR("{}: blocking snapshot request from the HTTP engine thread rejected", symbol);
         return DepthSnapshot{};
     }
 
-    return parseSnapshotResponse(response);
+    return getDepthSnapshotAsync(symbol, limit).get();
+}
+
+void BinanceAPI::fetchDepthSnapshot(const std::string &symbol, int limit, SnapshotCompletion completion)
+{
+    // The engine parses on its own thread, so no thread is spawned per request
+    auto onResponse = [completion = std::move(completion)](HttpResponse &&response) {
+        if (!response.ok())
+        {
+            LOG_WARN("Snapshot request failed: {} (HTTP {})", response.error, response.status);
+            completion(DepthSnapshot{});
+            return;
+        }
+        completion(parseSnapshotResponse(response.body));
+    };
+
+    HttpEngine::instance().submit(buildSnapshotUrl(symbol, limit), getDepthRequestWeight(limit), std::move(onResponse));
 }
 
 std::future<DepthSnapshot> BinanceAPI::getDepthSnapshotAsync(const std::string &symbol, int limit)
 {
-    return std::async(std::launch::async, [symbol, limit]() { return getDepthSnapshot(symbol, limit); });
+    auto promise = std::make_shared<std::promise<DepthSnapshot>>();
+    std::future<DepthSnapshot> future = promise->get_future();
+
+    fetchDepthSnapshot(symbol, limit, [promise](DepthSnapshot &&snapshot) { promise->set_value(std::move(snapshot)); });
+
+    return future;
+}
+
+double BinanceAPI::parseTickSize(const std::string &response)
+{
+    try
+    {
+        Json::Value root;
+        Json::Reader reader;
+
+        if (!reader.parse(response, root) || !root.isMember("symbols") || root["symbols"].empty())
+        {
+            LOG_ERROR("Failed to parse exchangeInfo response");
+            return 0.0;
+        }
+
+        for (const auto &filter : root["symbols"][0]["filters"])
+        {
+            if (filter["filterType"].asString() == "PRICE_FILTER")
+            {
+                return std::stod(filter["tickSize"].asString());
+            }
+        }
+        LOG_ERROR("No PRICE_FILTER in exchangeInfo response");
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR("Error parsing exchangeInfo: {}", e.what());
+    }
+
+    return 0.0;
+}
+
+void BinanceAPI::fetchTickSize(const std::string &symbol, TickSizeCompletion completion)
+{
+    auto onResponse = [completion = std::move(completion)](HttpResponse &&response) {
+        if (!response.ok())
+        {
+            LOG_WARN("exchangeInfo request failed: {} (HTTP {})", response.error, response.status);
+            completion(0.0);
+            return;
+        }
+        completion(parseTickSize(response.body));
+    };
+
+    HttpEngine::instance().submit("https://api.binance.com/api/v3/exchangeInfo?symbol=" + upperCase(symbol),
+                                  EXCHANGE_INFO_WEIGHT, std::move(onResponse));
 }
@@ -0,0 +1,141 @@
+#include "BookAudit.h"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+namespace
+{
+// An empty side has no range, so nothing on it is compared
+constexpr double NO_BID_RANGE = std::numeric_limits<double>::infinity();
+} // namespace
+
+void BookAudit::rollForward(DepthSnapshot &snapshot, const std::vector<AuditDelta> &deltas, long long targetId)
+{
+    // Only the snapshot's own range is complete; changes beyond it can't be checked
+    double worstBid = snapshot.bids.empty() ? NO_BID_RANGE : snapshot.bids.rbegin()->first;
+    double worstAsk = snapshot.asks.empty() ? 0.0 : snapshot.asks.rbegin()->first;
+
+    for (const AuditDelta &delta : deltas)
+    {
+        if (delta.updateId <= snapshot.lastUpdateId || delta.updateId > targetId)
+        {
+            continue;
+        }
+
+        if (delta.side == BookSide::BID && delta.price >= worstBid)
+        {
+            if (delta.quantity == 0.0)
+                snapshot.bids.erase(delta.price);
+            else
+                snapshot.bids[delta.price] = delta.quantity;
+        }
+        else if (delta.side == BookSide::ASK && delta.price <= worstAsk)
+        {
+            if (delta.quantity == 0.0)
+                snapshot.asks.erase(delta.price);
+            else
+                snapshot.asks[delta.price] = delta.quantity;
+        }
+    }
+
+    snapshot.lastUpdateId = targetId;
+}
+
+template <typename Levels> void BookAudit::flatten(const Levels &levels, FlatSide &out)
+{
+    out.prices.clear();
+    out.quantities.clear();
+    for (const auto &[price, quantity] : levels)
+    {
+        out.prices.push_back(price);
+        out.quantities.push_back(quantity);
+    }
+}
+
+void BookAudit::flatten(const std::vector<OrderBookLevel> &levels, size_t count, double worstPrice, bool bids,
+                        FlatSide &out)
+{
+    out.prices.clear();
+    out.quantities.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        double price = levels[i].getPrice();
+        if (bids ? price < worstPrice : price > worstPrice)
+        {
+            break;
+        }
+        out.prices.push_back(price);
+        out.quantities.push_back(levels[i].getQuantity());
+    }
+}
+
+void BookAudit::compareSide(const FlatSide &reference, const FlatSide &live, BookSide side, bool bounded,
+                            BookAuditResult &result)
+{
+    size_t count = std::min(reference.prices.size(), live.prices.size());
+    const double *referencePrices = reference.prices.data();
+    const double *referenceQuantities = reference.quantities.data();
+    const double *livePrices = live.prices.data();
+    const double *liveQuantities = live.quantities.data();
+
+    // Both feeds parse the same decimal text, so equal levels are bit-identical. OR-ing the XOR of
+    // every pair is a plain integer reduction over contiguous doubles, which the compiler
+    // vectorizes; the count and first position only need a scalar pass once something differs.
+    uint64_t difference = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        difference |= (std::bit_cast<uint64_t>(referencePrices[i]) ^ std::bit_cast<uint64_t>(livePrices[i])) |
+                      (std::bit_cast<uint64_t>(referenceQuantities[i]) ^ std::bit_cast<uint64_t>(liveQuantities[i]));
+    }
+
+    size_t mismatches = 0;
+    size_t firstMismatch = count;
+    if (difference != 0)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (referencePrices[i] != livePrices[i] || referenceQuantities[i] != liveQuantities[i])
+            {
+                firstMismatch = std::min(firstMismatch, i);
+                mismatches++;
+            }
+        }
+    }
+
+    // Extra or missing levels at the tail are drift too, unless the live book prunes its tail
+    size_t longer = std::max(reference.prices.size(), live.prices.size());
+    if (!bounded && longer > count)
+    {
+        mismatches += longer - count;
+    }
+
+    result.comparedLevels += bounded ? count : longer;
+    if (mismatches > 0 && result.mismatchedLevels == 0)
+    {
+        result.firstMismatchSide = side;
+        if (firstMismatch < count)
+            result.firstMismatchPrice = referencePrices[firstMismatch];
+        else
+            result.firstMismatchPrice =
+                reference.prices.size() > count ? reference.prices[count] : live.prices[count];
+    }
+    result.mismatchedLevels += mismatches;
+}
+
+BookAuditResult BookAudit::compare(const DepthSnapshot &reference, const LevelWindow &live, bool bounded)
+{
+    flatten(reference.bids, referenceBids);
+    flatten(reference.asks, referenceAsks);
+
+    double worstBid = referenceBids.prices.empty() ? NO_BID_RANGE : referenceBids.prices.back();
+    double worstAsk = referenceAsks.prices.empty() ? 0.0 : referenceAsks.prices.back();
+    flatten(live.bids, live.bidCount, worstBid, true, liveBids);
+    flatten(live.asks, live.askCount, worstAsk, false, liveAsks);
+
+    BookAuditResult result;
+    result.updateId = reference.lastUpdateId;
+    compareSide(referenceBids, liveBids, BookSide::BID, bounded, result);
+    compareSide(referenceAsks, liveAsks, BookSide::ASK, bounded, result);
+    return result;
+}
@@ -0,0 +1,122 @@
+#include "BookCheckpoint.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+int64_t wallClockNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+template <typename Map> void writeLevels(std::ofstream &out, const Map &levels)
+{
+    std::vector<double> flat;
+    flat.reserve(levels.size() * 2);
+    for (const auto &[price, quantity] : levels)
+    {
+        flat.push_back(price);
+        flat.push_back(quantity);
+    }
+    out.write(reinterpret_cast<const char *>(flat.data()), static_cast<std::streamsize>(flat.size() * sizeof(double)));
+}
+
+template <typename Map> bool readLevels(std::ifstream &in, Map &levels, uint64_t count)
+{
+    std::vector<double> flat(count * 2);
+    in.read(reinterpret_cast<char *>(flat.data()), static_cast<std::streamsize>(flat.size() * sizeof(double)));
+    if (!in)
+    {
+        return false;
+    }
+
+    // Levels were written in book order, so hinted inserts at the end stay O(1)
+    for (size_t i = 0; i < flat.size(); i += 2)
+    {
+        levels.emplace_hint(levels.end(), flat[i], flat[i + 1]);
+    }
+    return true;
+}
+} // namespace
+
+bool BookCheckpoint::save(const std::string &path, const OrderBookData &book)
+{
+    std::error_code ec;
+    std::filesystem::path target(path);
+    if (target.has_parent_path())
+    {
+        std::filesystem::create_directories(target.parent_path(), ec);
+    }
+
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            return false;
+        }
+
+        Header header{};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.lastUpdateId = book.getLastUpdateId();
+        header.savedAtNs = wallClockNs();
+        header.bidCount = book.getBids().size();
+        header.askCount = book.getAsks().size();
+
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        writeLevels(out, book.getBids());
+        writeLevels(out, book.getAsks());
+
+        if (!out)
+        {
+            return false;
+        }
+    }
+
+    return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+bool BookCheckpoint::load(const std::string &path, OrderBookData &book, int64_t maxAgeSeconds)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        return false;
+    }
+
+    Header header{};
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!in || header.magic != MAGIC || header.version != VERSION)
+    {
+        return false;
+    }
+
+    // Reject truncated or corrupt files before sizing any buffers from the header
+    std::error_code ec;
+    uint64_t expectedSize = sizeof(header) + (header.bidCount + header.askCount) * 2 * sizeof(double);
+    if (std::filesystem::file_size(path, ec) != expectedSize || ec)
+    {
+        return false;
+    }
+
+    int64_t ageNs = wallClockNs() - header.savedAtNs;
+    if (ageNs < 0 || ageNs > maxAgeSeconds * 1000000000LL)
+    {
+        return false;
+    }
+
+    OrderBookData loaded;
+    if (!readLevels(in, loaded.getBids(), header.bidCount) || !readLevels(in, loaded.getAsks(), header.askCount))
+    {
+        return false;
+    }
+    loaded.setLastUpdateId(header.lastUpdateId);
+
+    book = std::move(loaded);
+    return true;
+}
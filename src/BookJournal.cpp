@@ -0,0 +1,457 @@
+#include "BookJournal.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+int64_t toFixed(double value)
+{
+    return static_cast<int64_t>(std::llround(value * JOURNAL_FIXED_SCALE));
+}
+
+double fromFixed(int64_t value)
+{
+    return static_cast<double>(value) / JOURNAL_FIXED_SCALE;
+}
+
+void setLevel(OrderBookData &book, JournalSide side, double price, double quantity)
+{
+    if (side == JournalSide::BID)
+    {
+        if (quantity == 0.0)
+            book.getBids().erase(price);
+        else
+            book.getBids()[price] = quantity;
+    }
+    else
+    {
+        if (quantity == 0.0)
+            book.getAsks().erase(price);
+        else
+            book.getAsks()[price] = quantity;
+    }
+}
+} // namespace
+
+// JournalColumn
+
+JournalColumn::~JournalColumn()
+{
+    close();
+}
+
+bool JournalColumn::open(const std::string &path, size_t valueSize, bool forWriting)
+{
+    close();
+
+    writable = forWriting;
+    elementSize = valueSize;
+
+    fd = ::open(path.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close();
+        return false;
+    }
+
+    size_t fileSize = static_cast<size_t>(st.st_size);
+    bool fresh = fileSize < HEADER_SIZE;
+
+    if (fresh)
+    {
+        if (!writable)
+        {
+            close();
+            return false;
+        }
+
+        fileSize = HEADER_SIZE + INITIAL_CAPACITY * elementSize;
+        if (ftruncate(fd, static_cast<off_t>(fileSize)) != 0)
+        {
+            close();
+            return false;
+        }
+    }
+
+    if (!map(fileSize))
+    {
+        close();
+        return false;
+    }
+
+    Header *header = reinterpret_cast<Header *>(base);
+    if (fresh)
+    {
+        std::memset(header, 0, HEADER_SIZE);
+        header->magic = MAGIC;
+        header->elementSize = elementSize;
+    }
+    else if (header->magic != MAGIC || header->elementSize != elementSize)
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void JournalColumn::close()
+{
+    if (base)
+    {
+        munmap(base, mappedSize);
+        base = nullptr;
+        mappedSize = 0;
+    }
+
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool JournalColumn::map(size_t size)
+{
+    int protection = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void *mapped = mmap(nullptr, size, protection, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED)
+    {
+        return false;
+    }
+
+    base = static_cast<char *>(mapped);
+    mappedSize = size;
+    return true;
+}
+
+bool JournalColumn::grow(size_t minimumSize)
+{
+    size_t newSize = std::max(mappedSize * 2, minimumSize);
+
+    munmap(base, mappedSize);
+    base = nullptr;
+
+    if (ftruncate(fd, static_cast<off_t>(newSize)) != 0)
+    {
+        return map(mappedSize);
+    }
+
+    return map(newSize);
+}
+
+bool JournalColumn::append(const void *value)
+{
+    if (!base || !writable)
+    {
+        return false;
+    }
+
+    Header *header = reinterpret_cast<Header *>(base);
+    size_t offset = HEADER_SIZE + header->count * elementSize;
+
+    if (offset + elementSize > mappedSize)
+    {
+        if (!grow(offset + elementSize))
+        {
+            return false;
+        }
+        header = reinterpret_cast<Header *>(base);
+    }
+
+    std::memcpy(base + offset, value, elementSize);
+
+    // Publish the row only once its bytes are in place
+    header->count++;
+    return true;
+}
+
+size_t JournalColumn::size() const
+{
+    if (!base)
+    {
+        return 0;
+    }
+
+    // A reader maps the file as it was when opened; a live writer may count rows past that since
+    size_t mappedCount = (mappedSize - HEADER_SIZE) / elementSize;
+    return std::min<size_t>(reinterpret_cast<const Header *>(base)->count, mappedCount);
+}
+
+// JournalFiles
+
+bool JournalFiles::open(const std::string &directory, bool forWriting)
+{
+    auto path = [&directory](const char *name) { return directory + "/" + name; };
+
+    return deltaTime.open(path("delta_time.col"), sizeof(int64_t), forWriting) &&
+           deltaUpdateId.open(path("delta_update_id.col"), sizeof(int64_t), forWriting) &&
+           deltaSide.open(path("delta_side.col"), sizeof(uint8_t), forWriting) &&
+           deltaPrice.open(path("delta_price.col"), sizeof(int64_t), forWriting) &&
+           deltaQuantity.open(path("delta_quantity.col"), sizeof(int64_t), forWriting) &&
+           checkpointSide.open(path("checkpoint_side.col"), sizeof(uint8_t), forWriting) &&
+           checkpointPrice.open(path("checkpoint_price.col"), sizeof(int64_t), forWriting) &&
+           checkpointQuantity.open(path("checkpoint_quantity.col"), sizeof(int64_t), forWriting) &&
+           index.open(path("index.col"), sizeof(JournalIndexEntry), forWriting);
+}
+
+// BookJournal
+
+BookJournal::BookJournal(const std::string &journalDirectory) : directory(journalDirectory)
+{
+}
+
+bool BookJournal::open()
+{
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec)
+    {
+        return false;
+    }
+
+    opened = files.open(directory, true);
+    return opened;
+}
+
+bool BookJournal::isOpen() const
+{
+    return opened;
+}
+
+void BookJournal::appendDelta(int64_t timestampNs, long long updateId, JournalSide side, double price, double quantity)
+{
+    if (!opened)
+    {
+        return;
+    }
+
+    int64_t id = updateId;
+    uint8_t sideValue = static_cast<uint8_t>(side);
+    int64_t fixedPrice = toFixed(price);
+    int64_t fixedQuantity = toFixed(quantity);
+
+    files.deltaTime.append(&timestampNs);
+    files.deltaUpdateId.append(&id);
+    files.deltaSide.append(&sideValue);
+    files.deltaPrice.append(&fixedPrice);
+    files.deltaQuantity.append(&fixedQuantity);
+
+    deltasSinceCheckpoint++;
+}
+
+void BookJournal::appendCheckpointLevel(JournalSide side, double price, double quantity)
+{
+    uint8_t sideValue = static_cast<uint8_t>(side);
+    int64_t fixedPrice = toFixed(price);
+    int64_t fixedQuantity = toFixed(quantity);
+
+    files.checkpointSide.append(&sideValue);
+    files.checkpointPrice.append(&fixedPrice);
+    files.checkpointQuantity.append(&fixedQuantity);
+}
+
+void BookJournal::appendCheckpoint(int64_t timestampNs, const OrderBookData &book)
+{
+    if (!opened)
+    {
+        return;
+    }
+
+    JournalIndexEntry entry{};
+    entry.timestampNs = timestampNs;
+    entry.updateId = book.getLastUpdateId();
+    entry.deltaOffset = files.deltaTime.size();
+    entry.checkpointOffset = files.checkpointSide.size();
+    entry.levelCount = book.getBids().size() + book.getAsks().size();
+
+    for (const auto &[price, quantity] : book.getBids())
+    {
+        appendCheckpointLevel(JournalSide::BID, price, quantity);
+    }
+    for (const auto &[price, quantity] : book.getAsks())
+    {
+        appendCheckpointLevel(JournalSide::ASK, price, quantity);
+    }
+
+    // The index entry goes last so a checkpoint is only visible once complete
+    files.index.append(&entry);
+    deltasSinceCheckpoint = 0;
+}
+
+bool BookJournal::isCheckpointDue() const
+{
+    return opened && deltasSinceCheckpoint >= CHECKPOINT_INTERVAL;
+}
+
+int64_t BookJournal::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+// BookJournalReader
+
+BookJournalReader::BookJournalReader(const std::string &journalDirectory) : directory(journalDirectory)
+{
+}
+
+bool BookJournalReader::open()
+{
+    return files.open(directory, false);
+}
+
+size_t BookJournalReader::getDeltaCount() const
+{
+    // Columns are appended one after another, so the shortest one bounds the complete rows
+    return std::min({files.deltaTime.size(), files.deltaUpdateId.size(), files.deltaSide.size(),
+                     files.deltaPrice.size(), files.deltaQuantity.size()});
+}
+
+size_t BookJournalReader::getCheckpointCount() const
+{
+    // An entry is only usable if its rows and deltas fall inside what this reader mapped
+    const JournalIndexEntry *entries = files.index.values<JournalIndexEntry>();
+    size_t checkpointRows =
+        std::min({files.checkpointSide.size(), files.checkpointPrice.size(), files.checkpointQuantity.size()});
+    size_t deltaCount = getDeltaCount();
+
+    size_t count = files.index.size();
+    while (count > 0 && (entries[count - 1].checkpointOffset + entries[count - 1].levelCount > checkpointRows ||
+                         entries[count - 1].deltaOffset > deltaCount))
+    {
+        count--;
+    }
+    return count;
+}
+
+JournalDelta BookJournalReader::getDelta(size_t index) const
+{
+    JournalDelta delta;
+    delta.timestampNs = files.deltaTime.values<int64_t>()[index];
+    delta.updateId = files.deltaUpdateId.values<int64_t>()[index];
+    delta.side = static_cast<JournalSide>(files.deltaSide.values<uint8_t>()[index]);
+    delta.price = fromFixed(files.deltaPrice.values<int64_t>()[index]);
+    delta.quantity = fromFixed(files.deltaQuantity.values<int64_t>()[index]);
+    return delta;
+}
+
+const JournalIndexEntry &BookJournalReader::getCheckpoint(size_t index) const
+{
+    return files.index.values<JournalIndexEntry>()[index];
+}
+
+void BookJournalReader::loadCheckpoint(const JournalIndexEntry &entry, OrderBookData &book) const
+{
+    book.clear();
+
+    const uint8_t *sides = files.checkpointSide.values<uint8_t>();
+    const int64_t *prices = files.checkpointPrice.values<int64_t>();
+    const int64_t *quantities = files.checkpointQuantity.values<int64_t>();
+
+    // Checkpoint rows are written in book order, so hinted inserts at the end stay O(1)
+    BidsMap &bids = book.getBids();
+    AsksMap &asks = book.getAsks();
+    size_t end = entry.checkpointOffset + entry.levelCount;
+    for (size_t i = entry.checkpointOffset; i < end; ++i)
+    {
+        double price = fromFixed(prices[i]);
+        double quantity = fromFixed(quantities[i]);
+        if (static_cast<JournalSide>(sides[i]) == JournalSide::BID)
+            bids.emplace_hint(bids.end(), price, quantity);
+        else
+            asks.emplace_hint(asks.end(), price, quantity);
+    }
+
+    book.setLastUpdateId(entry.updateId);
+}
+
+void BookJournalReader::replayDeltas(size_t begin, size_t end, OrderBookData &book) const
+{
+    const int64_t *updateIds = files.deltaUpdateId.values<int64_t>();
+    const uint8_t *sides = files.deltaSide.values<uint8_t>();
+    const int64_t *prices = files.deltaPrice.values<int64_t>();
+    const int64_t *quantities = files.deltaQuantity.values<int64_t>();
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        setLevel(book, static_cast<JournalSide>(sides[i]), fromFixed(prices[i]), fromFixed(quantities[i]));
+    }
+
+    if (end > begin)
+    {
+        book.setLastUpdateId(updateIds[end - 1]);
+    }
+}
+
+size_t BookJournalReader::replayLimit(size_t nextCheckpoint) const
+{
+    // Counts the next checkpoint even when its rows are past this mapping
+    size_t deltaCount = getDeltaCount();
+    if (nextCheckpoint < files.index.size())
+    {
+        return std::min<size_t>(files.index.values<JournalIndexEntry>()[nextCheckpoint].deltaOffset, deltaCount);
+    }
+    return deltaCount;
+}
+
+bool BookJournalReader::reconstructAt(int64_t timestampNs, OrderBookData &book) const
+{
+    const JournalIndexEntry *entries = files.index.values<JournalIndexEntry>();
+    const JournalIndexEntry *entriesEnd = entries + getCheckpointCount();
+
+    // Latest checkpoint taken at or before T
+    auto it = std::upper_bound(entries, entriesEnd, timestampNs,
+                               [](int64_t t, const JournalIndexEntry &entry) { return t < entry.timestampNs; });
+    if (it == entries)
+    {
+        return false;
+    }
+    const JournalIndexEntry &checkpoint = *(it - 1);
+
+    loadCheckpoint(checkpoint, book);
+
+    // Never replay past the next checkpoint; a resync may have replaced the book there
+    const int64_t *times = files.deltaTime.values<int64_t>();
+    size_t limit = replayLimit(it - entries);
+    size_t end = std::upper_bound(times + checkpoint.deltaOffset, times + limit, timestampNs) - times;
+    replayDeltas(checkpoint.deltaOffset, end, book);
+    return true;
+}
+
+bool BookJournalReader::reconstructAtUpdateId(long long updateId, OrderBookData &book) const
+{
+    const JournalIndexEntry *entries = files.index.values<JournalIndexEntry>();
+    const JournalIndexEntry *entriesEnd = entries + getCheckpointCount();
+
+    auto it = std::upper_bound(entries, entriesEnd, static_cast<int64_t>(updateId),
+                               [](int64_t id, const JournalIndexEntry &entry) { return id < entry.updateId; });
+    if (it == entries)
+    {
+        return false;
+    }
+    const JournalIndexEntry &checkpoint = *(it - 1);
+
+    loadCheckpoint(checkpoint, book);
+
+    const int64_t *updateIds = files.deltaUpdateId.values<int64_t>();
+    size_t limit = replayLimit(it - entries);
+    size_t end =
+        std::upper_bound(updateIds + checkpoint.deltaOffset, updateIds + limit, static_cast<int64_t>(updateId)) -
+        updateIds;
+    replayDeltas(checkpoint.deltaOffset, end, book);
+    return true;
+}
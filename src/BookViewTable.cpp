@@ -0,0 +1,155 @@
+#include "BookViewTable.h"
+#include <algorithm>
+#include <stdexcept>
+
+BookViewTable::BookViewTable(size_t maxSymbols, size_t levelsPerSide)
+    : capacity(maxSymbols), depth(levelsPerSide), sequences(std::make_unique<std::atomic<uint32_t>[]>(maxSymbols)),
+      updateIds(std::make_unique<long long[]>(maxSymbols)), receiveTimes(std::make_unique<int64_t[]>(maxSymbols)),
+      bidCounts(std::make_unique<uint32_t[]>(maxSymbols)), askCounts(std::make_unique<uint32_t[]>(maxSymbols)),
+      levels(std::make_unique<double[]>(maxSymbols * levelsPerSide * 4))
+{
+    symbols.reserve(maxSymbols);
+}
+
+double *BookViewTable::rowLevels(size_t slot) const
+{
+    return levels.get() + slot * depth * 4;
+}
+
+size_t BookViewTable::addSymbol(const std::string &symbol)
+{
+    std::lock_guard<std::mutex> lock(symbolsMutex);
+
+    auto existing = std::find(symbols.begin(), symbols.end(), symbol);
+    if (existing != symbols.end())
+    {
+        return existing - symbols.begin();
+    }
+    if (symbols.size() == capacity)
+    {
+        throw std::length_error("BookViewTable is full");
+    }
+
+    symbols.push_back(symbol);
+    rows.store(symbols.size(), std::memory_order_release);
+    return symbols.size() - 1;
+}
+
+size_t BookViewTable::findSymbol(const std::string &symbol) const
+{
+    std::lock_guard<std::mutex> lock(symbolsMutex);
+    auto existing = std::find(symbols.begin(), symbols.end(), symbol);
+    return existing != symbols.end() ? static_cast<size_t>(existing - symbols.begin()) : NOT_FOUND;
+}
+
+void BookViewTable::publish(size_t slot, const OrderBookData &book, long long updateId, int64_t receiveTimeNs)
+{
+    // Odd while the row is being written. The epoch bump is a full barrier: a reader whose
+    // first epoch load sees it also sees the odd sequence, and the row stores stay after it.
+    std::atomic<uint32_t> &sequence = sequences[slot];
+    uint32_t current = sequence.load(std::memory_order_relaxed);
+    sequence.store(current + 1, std::memory_order_relaxed);
+    epoch.fetch_add(1, std::memory_order_seq_cst);
+
+    double *row = rowLevels(slot);
+    uint32_t bids = 0;
+    for (auto it = book.getBids().begin(); it != book.getBids().end() && bids < depth; ++it, ++bids)
+    {
+        std::atomic_ref<double>(row[bids]).store(it->first, std::memory_order_relaxed);
+        std::atomic_ref<double>(row[depth + bids]).store(it->second, std::memory_order_relaxed);
+    }
+    uint32_t asks = 0;
+    for (auto it = book.getAsks().begin(); it != book.getAsks().end() && asks < depth; ++it, ++asks)
+    {
+        std::atomic_ref<double>(row[2 * depth + asks]).store(it->first, std::memory_order_relaxed);
+        std::atomic_ref<double>(row[3 * depth + asks]).store(it->second, std::memory_order_relaxed);
+    }
+
+    std::atomic_ref<uint32_t>(bidCounts[slot]).store(bids, std::memory_order_relaxed);
+    std::atomic_ref<uint32_t>(askCounts[slot]).store(asks, std::memory_order_relaxed);
+    std::atomic_ref<long long>(updateIds[slot]).store(updateId, std::memory_order_relaxed);
+    std::atomic_ref<int64_t>(receiveTimes[slot]).store(receiveTimeNs, std::memory_order_relaxed);
+
+    sequence.store(current + 2, std::memory_order_release);
+}
+
+void BookViewTable::copyRow(size_t slot, BookView &view) const
+{
+    const std::atomic<uint32_t> &sequence = sequences[slot];
+    double *row = rowLevels(slot);
+    uint32_t before;
+    uint32_t after;
+    do
+    {
+        before = sequence.load(std::memory_order_acquire);
+
+        // Counts are clamped so a torn read that is about to be discarded stays in bounds
+        uint32_t bids = std::min<uint32_t>(
+            std::atomic_ref<uint32_t>(bidCounts[slot]).load(std::memory_order_relaxed), depth);
+        uint32_t asks = std::min<uint32_t>(
+            std::atomic_ref<uint32_t>(askCounts[slot]).load(std::memory_order_relaxed), depth);
+
+        view.bids.clear();
+        for (uint32_t i = 0; i < bids; ++i)
+        {
+            view.bids.emplace_back(std::atomic_ref<double>(row[i]).load(std::memory_order_relaxed),
+                                   std::atomic_ref<double>(row[depth + i]).load(std::memory_order_relaxed));
+        }
+        view.asks.clear();
+        for (uint32_t i = 0; i < asks; ++i)
+        {
+            view.asks.emplace_back(std::atomic_ref<double>(row[2 * depth + i]).load(std::memory_order_relaxed),
+                                   std::atomic_ref<double>(row[3 * depth + i]).load(std::memory_order_relaxed));
+        }
+        view.updateId = std::atomic_ref<long long>(updateIds[slot]).load(std::memory_order_relaxed);
+        view.receiveTimeNs = std::atomic_ref<int64_t>(receiveTimes[slot]).load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+}
+
+bool BookViewTable::read(const std::vector<size_t> &slots, MultiBookView &out, int maxAttempts) const
+{
+    size_t available = rows.load(std::memory_order_acquire);
+    for (size_t slot : slots)
+    {
+        if (slot >= available)
+        {
+            throw std::out_of_range("BookViewTable slot was never added");
+        }
+    }
+
+    out.views.resize(slots.size());
+    for (int attempt = 0; attempt < std::max(maxAttempts, 1); ++attempt)
+    {
+        // Every write that started before the first load is whole in the copies. If the epoch
+        // has not moved by the second load, no write started in between, so the copies are the
+        // books as they stood at the first load.
+        uint64_t start = epoch.load(std::memory_order_seq_cst);
+        for (size_t i = 0; i < slots.size(); ++i)
+        {
+            copyRow(slots[i], out.views[i]);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t end = epoch.load(std::memory_order_seq_cst);
+
+        out.epoch = start;
+        out.consistent = start == end;
+        if (out.consistent)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t BookViewTable::getDepth() const
+{
+    return depth;
+}
+
+size_t BookViewTable::size() const
+{
+    return rows.load(std::memory_order_acquire);
+}
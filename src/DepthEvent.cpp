@@ -0,0 +1,249 @@
+#include "DepthEvent.h"
+#include <charconv>
+
+namespace
+{
+// Single-pass scanner over the fields of a depthUpdate frame. It reads U, u, b and a in place
+// and skips everything else without building a document tree or copying strings.
+class DepthScanner
+{
+  private:
+    std::string_view text;
+    size_t pos = 0;
+
+    static constexpr int MAX_NESTING = 32;
+
+    void skipSpace()
+    {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r'))
+        {
+            pos++;
+        }
+    }
+
+    bool consume(char c)
+    {
+        skipSpace();
+        if (pos < text.size() && text[pos] == c)
+        {
+            pos++;
+            return true;
+        }
+        return false;
+    }
+
+    bool peek(char c)
+    {
+        skipSpace();
+        return pos < text.size() && text[pos] == c;
+    }
+
+    // Contents between the quotes; escapes are skipped over, not decoded
+    bool readString(std::string_view &out)
+    {
+        if (!consume('"'))
+        {
+            return false;
+        }
+        size_t start = pos;
+        while (pos < text.size() && text[pos] != '"')
+        {
+            pos += text[pos] == '\\' ? 2 : 1;
+        }
+        if (pos >= text.size())
+        {
+            return false;
+        }
+        out = text.substr(start, pos - start);
+        pos++;
+        return true;
+    }
+
+    bool readInteger(long long &out)
+    {
+        skipSpace();
+        auto result = std::from_chars(text.data() + pos, text.data() + text.size(), out);
+        if (result.ec != std::errc())
+        {
+            return false;
+        }
+        pos = result.ptr - text.data();
+        return true;
+    }
+
+    // Binance quotes prices and quantities, but a bare number is accepted too
+    bool readDecimal(double &out)
+    {
+        std::string_view digits;
+        if (peek('"'))
+        {
+            if (!readString(digits))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            size_t start = pos;
+            while (pos < text.size() && text[pos] != ',' && text[pos] != ']' && text[pos] != '}' &&
+                   text[pos] != ' ')
+            {
+                pos++;
+            }
+            digits = text.substr(start, pos - start);
+        }
+        auto result = std::from_chars(digits.data(), digits.data() + digits.size(), out);
+        return result.ec == std::errc() && result.ptr == digits.data() + digits.size();
+    }
+
+    // [["price","qty",...],...]; extra entries in a level are ignored
+    bool readLevels(DepthLevels &levels)
+    {
+        if (!consume('['))
+        {
+            return false;
+        }
+        if (consume(']'))
+        {
+            return true;
+        }
+        do
+        {
+            double price;
+            double quantity;
+            if (!consume('[') || !readDecimal(price) || !consume(',') || !readDecimal(quantity))
+            {
+                return false;
+            }
+            while (consume(','))
+            {
+                if (!skipValue(0))
+                {
+                    return false;
+                }
+            }
+            if (!consume(']'))
+            {
+                return false;
+            }
+            levels.emplace_back(price, quantity);
+        } while (consume(','));
+        return consume(']');
+    }
+
+    bool skipValue(int depth)
+    {
+        if (depth > MAX_NESTING)
+        {
+            return false;
+        }
+
+        std::string_view ignored;
+        if (peek('"'))
+        {
+            return readString(ignored);
+        }
+        if (consume('{'))
+        {
+            if (consume('}'))
+            {
+                return true;
+            }
+            do
+            {
+                if (!readString(ignored) || !consume(':') || !skipValue(depth + 1))
+                {
+                    return false;
+                }
+            } while (consume(','));
+            return consume('}');
+        }
+        if (consume('['))
+        {
+            if (consume(']'))
+            {
+                return true;
+            }
+            do
+            {
+                if (!skipValue(depth + 1))
+                {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(']');
+        }
+
+        // Number, true, false or null
+        size_t start = pos;
+        while (pos < text.size() && text[pos] != ',' && text[pos] != ']' && text[pos] != '}')
+        {
+            pos++;
+        }
+        return pos > start;
+    }
+
+  public:
+    explicit DepthScanner(std::string_view json) : text(json)
+    {
+    }
+
+    // Fields of the depth update may sit at the top level or inside "data"
+    bool readObject(DepthEvent &event, int depth)
+    {
+        if (depth > 1 || !consume('{'))
+        {
+            return false;
+        }
+        if (consume('}'))
+        {
+            return true;
+        }
+        do
+        {
+            std::string_view key;
+            if (!readString(key) || !consume(':'))
+            {
+                return false;
+            }
+
+            bool ok;
+            if (key == "data")
+                ok = readObject(event, depth + 1);
+            else if (key == "U")
+                ok = readInteger(event.firstUpdateId);
+            else if (key == "u")
+                ok = readInteger(event.finalUpdateId);
+            else if (key == "b")
+                ok = readLevels(event.bids);
+            else if (key == "a")
+                ok = readLevels(event.asks);
+            else
+                ok = skipValue(0);
+
+            if (!ok)
+            {
+                return false;
+            }
+        } while (consume(','));
+        return consume('}');
+    }
+};
+} // namespace
+
+bool parseDepthUpdate(std::string_view json, DepthEvent &event)
+{
+    event.firstUpdateId = 0;
+    event.finalUpdateId = 0;
+    event.bids.clear();
+    event.asks.clear();
+    event.timestamp = std::chrono::steady_clock::now();
+
+    DepthScanner scanner(json);
+    if (!scanner.readObject(event, 0) || event.firstUpdateId == 0 || event.finalUpdateId == 0)
+    {
+        event.finalUpdateId = 0;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,488 @@
+#include "DepthHistory.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+constexpr double FIXED_SCALE = 1e8;
+constexpr size_t MIN_ARENA_BYTES = 64 * 1024;
+constexpr uint8_t KEYFRAME_FLAG = 1;
+
+int64_t toFixed(double value)
+{
+    return static_cast<int64_t>(std::llround(value * FIXED_SCALE));
+}
+
+void putVarint(std::vector<uint8_t> &out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void putSigned(std::vector<uint8_t> &out, int64_t value)
+{
+    putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+uint64_t getVarint(const uint8_t *&in)
+{
+    uint64_t value = 0;
+    for (int shift = 0;; shift += 7)
+    {
+        uint8_t byte = *in++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (byte < 0x80)
+        {
+            return value;
+        }
+    }
+}
+
+int64_t getSigned(const uint8_t *&in)
+{
+    uint64_t value = getVarint(in);
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Bids run from the highest price, asks from the lowest
+bool comesBefore(bool bids, int64_t a, int64_t b)
+{
+    return bids ? a > b : a < b;
+}
+
+// Entries as zig-zag price steps from the previous entry and fixed-point quantities
+void putLevels(std::vector<uint8_t> &out, const std::vector<std::pair<int64_t, int64_t>> &levels)
+{
+    putVarint(out, levels.size());
+    int64_t previous = 0;
+    for (const auto &[price, quantity] : levels)
+    {
+        putSigned(out, price - previous);
+        putVarint(out, static_cast<uint64_t>(quantity));
+        previous = price;
+    }
+}
+
+void getLevels(const uint8_t *&in, std::vector<std::pair<int64_t, int64_t>> &levels)
+{
+    size_t n = getVarint(in);
+    levels.clear();
+    int64_t price = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        price += getSigned(in);
+        levels.emplace_back(price, static_cast<int64_t>(getVarint(in)));
+    }
+}
+
+// Changes that turn previous into current, in side order; a zero quantity removes the level
+void putChanges(std::vector<uint8_t> &out, bool bids, const std::vector<std::pair<int64_t, int64_t>> &previous,
+                const std::vector<std::pair<int64_t, int64_t>> &current)
+{
+    // Counted first into a fixed-width slot so the entries can be written in one pass
+    size_t countAt = out.size();
+    out.resize(out.size() + 4);
+    uint32_t changes = 0;
+    int64_t last = 0;
+    auto emit = [&](int64_t price, int64_t quantity) {
+        putSigned(out, price - last);
+        putVarint(out, static_cast<uint64_t>(quantity));
+        last = price;
+        changes++;
+    };
+
+    size_t i = 0;
+    size_t j = 0;
+    while (i < previous.size() || j < current.size())
+    {
+        if (j == current.size() || (i < previous.size() && comesBefore(bids, previous[i].first, current[j].first)))
+        {
+            emit(previous[i++].first, 0);
+        }
+        else if (i == previous.size() || comesBefore(bids, current[j].first, previous[i].first))
+        {
+            emit(current[j].first, current[j].second);
+            j++;
+        }
+        else
+        {
+            if (previous[i].second != current[j].second)
+            {
+                emit(current[j].first, current[j].second);
+            }
+            i++;
+            j++;
+        }
+    }
+    std::memcpy(out.data() + countAt, &changes, sizeof(changes));
+}
+
+void applyChanges(const uint8_t *&in, bool bids, std::vector<std::pair<int64_t, int64_t>> &levels,
+                  std::vector<std::pair<int64_t, int64_t>> &scratch)
+{
+    uint32_t changes;
+    std::memcpy(&changes, in, sizeof(changes));
+    in += sizeof(changes);
+
+    scratch.clear();
+    size_t i = 0;
+    int64_t price = 0;
+    for (uint32_t n = 0; n < changes; ++n)
+    {
+        price += getSigned(in);
+        int64_t quantity = static_cast<int64_t>(getVarint(in));
+
+        while (i < levels.size() && comesBefore(bids, levels[i].first, price))
+        {
+            scratch.push_back(levels[i++]);
+        }
+        if (i < levels.size() && levels[i].first == price)
+        {
+            i++;
+        }
+        if (quantity != 0)
+        {
+            scratch.emplace_back(price, quantity);
+        }
+    }
+    scratch.insert(scratch.end(), levels.begin() + i, levels.end());
+    levels.swap(scratch);
+}
+
+void toLevels(const std::vector<std::pair<int64_t, int64_t>> &encoded, int64_t priceUnit,
+              std::vector<OrderBookLevel> &levels)
+{
+    levels.clear();
+    for (const auto &[price, quantity] : encoded)
+    {
+        levels.emplace_back(static_cast<double>(price * priceUnit) / FIXED_SCALE,
+                            static_cast<double>(quantity) / FIXED_SCALE);
+    }
+}
+} // namespace
+
+DepthHistory::DepthHistory(const DepthHistoryConfig &historyConfig)
+    : config(historyConfig), intervalNs(std::max<int64_t>(historyConfig.intervalMs, 1) * 1000000)
+{
+    config.keyframeInterval = std::max<size_t>(config.keyframeInterval, 1);
+    arena.resize(std::max(config.memoryBytes, MIN_ARENA_BYTES));
+
+    // Room for the whole horizon plus the group being written
+    size_t horizonFrames = static_cast<size_t>(config.horizonSeconds * 1000000000LL / intervalNs);
+    frames.resize(horizonFrames + config.keyframeInterval + 1);
+
+    for (EncodedLevels *levels : {&previousBids, &previousAsks, &currentBids, &currentAsks})
+    {
+        levels->reserve(config.levels);
+    }
+}
+
+bool DepthHistory::encodeSide(const OrderBookData &book, bool bids, EncodedLevels &out) const
+{
+    out.clear();
+    auto append = [&](const auto &side) {
+        for (auto it = side.begin(); it != side.end() && out.size() < config.levels; ++it)
+        {
+            int64_t price = toFixed(it->first);
+            if (price % priceUnit != 0)
+            {
+                return false;
+            }
+            out.emplace_back(price / priceUnit, toFixed(it->second));
+        }
+        return true;
+    };
+    return bids ? append(book.getBids()) : append(book.getAsks());
+}
+
+void DepthHistory::sample(const OrderBookData &book, int64_t nowNs)
+{
+    // The first event of a new interval; the book still holds the state at the boundary
+    int64_t slot = nowNs / intervalNs;
+    if (slot <= lastSlot)
+    {
+        return;
+    }
+    lastSlot = slot;
+
+    bool keyframe = framesSinceKeyframe == 0 || framesSinceKeyframe >= config.keyframeInterval;
+    if (!keyframe && !(encodeSide(book, true, currentBids) && encodeSide(book, false, currentAsks)))
+    {
+        keyframe = true; // A price off the current tick grid
+    }
+    if (keyframe)
+    {
+        double tick = book.getTickSize();
+        priceUnit = tick > 0.0 ? std::max<int64_t>(toFixed(tick), 1) : 1;
+        if (!(encodeSide(book, true, currentBids) && encodeSide(book, false, currentAsks)))
+        {
+            priceUnit = 1;
+            encodeSide(book, true, currentBids);
+            encodeSide(book, false, currentAsks);
+        }
+    }
+
+    encodeFrame(book.getLastUpdateId(), keyframe);
+    commitFrame(slot * intervalNs, keyframe);
+
+    previousBids.swap(currentBids);
+    previousAsks.swap(currentAsks);
+}
+
+void DepthHistory::encodeFrame(long long updateId, bool keyframe)
+{
+    encoded.clear();
+    encoded.push_back(keyframe ? KEYFRAME_FLAG : 0);
+    putVarint(encoded, static_cast<uint64_t>(updateId));
+    if (keyframe)
+    {
+        putVarint(encoded, static_cast<uint64_t>(priceUnit));
+        putLevels(encoded, currentBids);
+        putLevels(encoded, currentAsks);
+    }
+    else
+    {
+        putChanges(encoded, true, previousBids, currentBids);
+        putChanges(encoded, false, previousAsks, currentAsks);
+    }
+}
+
+void DepthHistory::evictOldest()
+{
+    // A whole group goes at once, so the oldest frame left is always a keyframe
+    do
+    {
+        head = (head + 1) % frames.size();
+        count--;
+    } while (count > 0 && !frames[head].keyframe);
+}
+
+void DepthHistory::commitFrame(int64_t timeNs, bool keyframe)
+{
+    ProfiledLock lock(historyMutex);
+
+    // Drop the oldest group once the next one alone still reaches back past the horizon
+    int64_t cutoff = timeNs - config.horizonSeconds * 1000000000LL;
+    while (count > 0)
+    {
+        size_t next = 1;
+        while (next < count && !frames[(head + next) % frames.size()].keyframe)
+        {
+            next++;
+        }
+        if (next == count || frames[(head + next) % frames.size()].timeNs > cutoff)
+        {
+            break;
+        }
+        evictOldest();
+    }
+    while (count == frames.size())
+    {
+        evictOldest();
+    }
+
+    // Frames sit in the arena in ring order, so the bytes ahead of the write offset belong to
+    // the oldest frames. Wrapping skips the tail, whose frames are the oldest of all.
+    size_t size = encoded.size();
+    if (writeOffset + size > arena.size())
+    {
+        while (count > 0 && frames[head].offset >= writeOffset)
+        {
+            evictOldest();
+        }
+        writeOffset = 0;
+    }
+    while (count > 0 && frames[head].offset >= writeOffset && frames[head].offset < writeOffset + size)
+    {
+        evictOldest();
+    }
+
+    // A delta whose keyframe was just evicted cannot be decoded; the next sample starts a group
+    if (count == 0 && !keyframe)
+    {
+        framesSinceKeyframe = 0;
+        return;
+    }
+
+    std::memcpy(arena.data() + writeOffset, encoded.data(), size);
+    frames[(head + count) % frames.size()] = {timeNs, writeOffset, static_cast<uint32_t>(size), keyframe};
+    count++;
+    writeOffset += size;
+    framesSinceKeyframe = keyframe ? 1 : framesSinceKeyframe + 1;
+}
+
+void DepthHistory::visitRange(int64_t fromNs, int64_t toNs,
+                              const std::function<void(const DepthFrame &)> &visitor) const
+{
+    std::vector<FrameEntry> entries;
+    std::vector<uint8_t> bytes;
+    {
+        ProfiledLock lock(historyMutex);
+
+        // Decode from the last keyframe at or before fromNs; the ring always starts with one
+        size_t start = 0;
+        size_t end = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const FrameEntry &entry = frames[(head + i) % frames.size()];
+            if (entry.timeNs > toNs)
+            {
+                break;
+            }
+            if (entry.keyframe && entry.timeNs <= fromNs)
+            {
+                start = i;
+            }
+            end = i + 1;
+        }
+
+        // Copied out so decoding runs without the lock
+        for (size_t i = start; i < end; ++i)
+        {
+            FrameEntry entry = frames[(head + i) % frames.size()];
+            const uint8_t *source = arena.data() + entry.offset;
+            entry.offset = bytes.size();
+            bytes.insert(bytes.end(), source, source + entry.size);
+            entries.push_back(entry);
+        }
+    }
+
+    // The frame in effect at fromNs is the last one at or before it
+    size_t firstVisited = 0;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (entries[i].timeNs <= fromNs)
+        {
+            firstVisited = i;
+        }
+    }
+
+    EncodedLevels bids;
+    EncodedLevels asks;
+    EncodedLevels scratch;
+    int64_t unit = 1;
+    DepthFrame frame;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const uint8_t *in = bytes.data() + entries[i].offset;
+        bool keyframe = (*in++ & KEYFRAME_FLAG) != 0;
+        frame.updateId = static_cast<long long>(getVarint(in));
+        if (keyframe)
+        {
+            unit = static_cast<int64_t>(getVarint(in));
+            getLevels(in, bids);
+            getLevels(in, asks);
+        }
+        else
+        {
+            applyChanges(in, true, bids, scratch);
+            applyChanges(in, false, asks, scratch);
+        }
+
+        if (i >= firstVisited)
+        {
+            frame.timeNs = entries[i].timeNs;
+            toLevels(bids, unit, frame.bids);
+            toLevels(asks, unit, frame.asks);
+            visitor(frame);
+        }
+    }
+}
+
+void DepthHistory::readHeatmap(int64_t fromNs, int64_t toNs, double priceLow, double priceHigh,
+                               HeatmapGrid &grid) const
+{
+    size_t cells = grid.rows * grid.columns;
+    grid.priceLow = priceLow;
+    grid.priceHigh = priceHigh;
+    grid.fromNs = fromNs;
+    grid.columnNs = grid.columns > 0 ? std::max<int64_t>((toNs - fromNs) / static_cast<int64_t>(grid.columns), 1) : 1;
+    grid.bidQuantity.assign(cells, 0.0);
+    grid.askQuantity.assign(cells, 0.0);
+    grid.maxQuantity = 0.0;
+    if (cells == 0 || priceHigh <= priceLow)
+    {
+        return;
+    }
+
+    double rowHeight = (priceHigh - priceLow) / static_cast<double>(grid.rows);
+    auto addLevels = [&](const std::vector<OrderBookLevel> &levels, std::vector<double> &cellQuantity,
+                         size_t column) {
+        for (const auto &level : levels)
+        {
+            double offset = (priceHigh - level.getPrice()) / rowHeight;
+            if (offset < 0.0 || offset >= static_cast<double>(grid.rows))
+            {
+                continue;
+            }
+            double &cell = cellQuantity[static_cast<size_t>(offset) * grid.columns + column];
+            cell += level.getQuantity();
+            grid.maxQuantity = std::max(grid.maxQuantity, cell);
+        }
+    };
+
+    // Each column shows the last frame before its end; quiet stretches carry the book forward
+    DepthFrame current;
+    bool haveFrame = false;
+    size_t filled = 0;
+    auto fillUntil = [&](int64_t timeNs) {
+        while (filled < grid.columns && fromNs + static_cast<int64_t>(filled + 1) * grid.columnNs <= timeNs)
+        {
+            if (haveFrame)
+            {
+                addLevels(current.bids, grid.bidQuantity, filled);
+                addLevels(current.asks, grid.askQuantity, filled);
+            }
+            filled++;
+        }
+    };
+
+    visitRange(fromNs, toNs, [&](const DepthFrame &frame) {
+        fillUntil(frame.timeNs);
+        current.timeNs = frame.timeNs;
+        current.bids = frame.bids;
+        current.asks = frame.asks;
+        haveFrame = true;
+    });
+    fillUntil(std::numeric_limits<int64_t>::max());
+}
+
+const DepthHistoryConfig &DepthHistory::getConfig() const
+{
+    return config;
+}
+
+size_t DepthHistory::getFrameCount() const
+{
+    ProfiledLock lock(historyMutex);
+    return count;
+}
+
+size_t DepthHistory::getEncodedBytes() const
+{
+    ProfiledLock lock(historyMutex);
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        bytes += frames[(head + i) % frames.size()].size;
+    }
+    return bytes;
+}
+
+int64_t DepthHistory::getOldestTimeNs() const
+{
+    ProfiledLock lock(historyMutex);
+    return count > 0 ? frames[head].timeNs : 0;
+}
+
+int64_t DepthHistory::getNewestTimeNs() const
+{
+    ProfiledLock lock(historyMutex);
+    return count > 0 ? frames[(head + count - 1) % frames.size()].timeNs : 0;
+}
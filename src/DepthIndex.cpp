@@ -0,0 +1,195 @@
+#include "DepthIndex.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace
+{
+// Room for the touch to improve before the index needs re-anchoring, as a fraction of capacity
+constexpr size_t ANCHOR_MARGIN_DIVISOR = 8;
+
+// Once the best level sits this far into the window, most of it is wasted; re-anchor
+constexpr size_t DRIFT_LIMIT_DIVISOR = 2;
+
+// Largest distance from a whole tick, in ticks, that still counts as float noise
+constexpr double GRID_EPSILON = 1e-6;
+} // namespace
+
+DepthIndex::DepthIndex(bool isBidSide) : bidSide(isBidSide)
+{
+}
+
+void DepthIndex::configure(size_t ticks, double tick)
+{
+    capacity = ticks > 0 ? std::bit_ceil(ticks) : 0;
+    tickSize = tick;
+    quantityTree.assign(capacity + 1, 0.0);
+    notionalTree.assign(capacity + 1, 0.0);
+    anchored = false;
+    offGrid = false;
+}
+
+bool DepthIndex::isActive() const
+{
+    return capacity > 0 && tickSize > 0.0;
+}
+
+bool DepthIndex::isReady() const
+{
+    return isActive() && anchored && !offGrid;
+}
+
+bool DepthIndex::isOffGrid() const
+{
+    return offGrid;
+}
+
+size_t DepthIndex::getCapacity() const
+{
+    return capacity;
+}
+
+int64_t DepthIndex::toTick(double price) const
+{
+    return std::llround(price / tickSize);
+}
+
+bool DepthIndex::isOnGrid(double price) const
+{
+    double ticks = price / tickSize;
+    return std::abs(ticks - std::round(ticks)) <= GRID_EPSILON;
+}
+
+int64_t DepthIndex::slotOf(double price) const
+{
+    int64_t tick = toTick(price);
+    return bidSide ? anchorTick - tick : tick - anchorTick;
+}
+
+double DepthIndex::priceOfSlot(int64_t slot) const
+{
+    return static_cast<double>(bidSide ? anchorTick - slot : anchorTick + slot) * tickSize;
+}
+
+double DepthIndex::nearEdgeOfSlot(int64_t slot) const
+{
+    return priceOfSlot(slot) + (bidSide ? tickSize : -tickSize) / 2.0;
+}
+
+int64_t DepthIndex::slotsWithin(double limitPrice) const
+{
+    if (bidSide)
+    {
+        int64_t lowestTick = static_cast<int64_t>(std::ceil(limitPrice / tickSize));
+        return anchorTick - lowestTick + 1;
+    }
+    int64_t highestTick = static_cast<int64_t>(std::floor(limitPrice / tickSize));
+    return highestTick - anchorTick + 1;
+}
+
+void DepthIndex::add(size_t slot, double quantity, double notional)
+{
+    for (size_t i = slot + 1; i <= capacity; i += i & (~i + 1))
+    {
+        quantityTree[i] += quantity;
+        notionalTree[i] += notional;
+    }
+}
+
+bool DepthIndex::update(double price, double oldQuantity, double newQuantity)
+{
+    if (!isActive() || offGrid || oldQuantity == newQuantity)
+    {
+        return true;
+    }
+    if (!isOnGrid(price))
+    {
+        offGrid = true;
+        clear();
+        return true;
+    }
+    if (!anchored)
+    {
+        return false;
+    }
+
+    int64_t slot = slotOf(price);
+    if (slot < 0)
+    {
+        return false; // Better than the anchor
+    }
+    if (slot >= static_cast<int64_t>(capacity))
+    {
+        return true; // Past the window; queries walk the map out there
+    }
+
+    double delta = newQuantity - oldQuantity;
+    add(static_cast<size_t>(slot), delta, price * delta);
+    return true;
+}
+
+bool DepthIndex::isDrifted(double bestPrice) const
+{
+    return isActive() && anchored && slotOf(bestPrice) >= static_cast<int64_t>(capacity / DRIFT_LIMIT_DIVISOR);
+}
+
+void DepthIndex::beginRebuild(double bestPrice)
+{
+    std::fill(quantityTree.begin(), quantityTree.end(), 0.0);
+    std::fill(notionalTree.begin(), notionalTree.end(), 0.0);
+
+    int64_t margin = static_cast<int64_t>(capacity / ANCHOR_MARGIN_DIVISOR);
+    int64_t bestTick = toTick(bestPrice);
+    anchorTick = bidSide ? bestTick + margin : bestTick - margin;
+    anchored = true;
+}
+
+void DepthIndex::finishRebuild()
+{
+    // Linear Fenwick construction from the raw slot values
+    for (size_t i = 1; i <= capacity; ++i)
+    {
+        size_t parent = i + (i & (~i + 1));
+        if (parent <= capacity)
+        {
+            quantityTree[parent] += quantityTree[i];
+            notionalTree[parent] += notionalTree[i];
+        }
+    }
+}
+
+void DepthIndex::clear()
+{
+    std::fill(quantityTree.begin(), quantityTree.end(), 0.0);
+    std::fill(notionalTree.begin(), notionalTree.end(), 0.0);
+    anchored = false;
+}
+
+DepthSum DepthIndex::prefix(size_t slots) const
+{
+    DepthSum sum;
+    for (size_t i = std::min(slots, capacity); i > 0; i -= i & (~i + 1))
+    {
+        sum.quantity += quantityTree[i];
+        sum.notional += notionalTree[i];
+    }
+    return sum;
+}
+
+size_t DepthIndex::lowerBound(double target, DepthSum &before) const
+{
+    // Binary lifting: descend the tree, keeping every node whose sum stays short of target
+    before = DepthSum{};
+    size_t position = 0;
+    for (size_t step = capacity; step > 0; step >>= 1)
+    {
+        size_t next = position + step;
+        if (next <= capacity && before.quantity + quantityTree[next] < target)
+        {
+            position = next;
+            before.quantity += quantityTree[next];
+            before.notional += notionalTree[next];
+        }
+    }
+    return position;
+}
@@ -0,0 +1,92 @@
+#include "FeedArbiter.h"
+
+FeedArbiter::FeedArbiter(size_t connectionCount)
+{
+    counters.reserve(connectionCount);
+    for (size_t i = 0; i < connectionCount; ++i)
+    {
+        counters.push_back(std::make_unique<ConnectionCounters>());
+    }
+}
+
+bool FeedArbiter::arbitrate(size_t connectionId, long long finalUpdateId)
+{
+    auto now = std::chrono::steady_clock::now();
+    ConnectionCounters &conn = *counters[connectionId];
+    conn.messages.fetch_add(1, std::memory_order_relaxed);
+
+    // All connections are serviced by the same event loop, so there is a single writer here
+    if (finalUpdateId > lastWinningUpdateId.load(std::memory_order_relaxed))
+    {
+        lastWinningUpdateId.store(finalUpdateId, std::memory_order_relaxed);
+        arrivals[finalUpdateId % ARRIVAL_HISTORY] = Arrival{finalUpdateId, now};
+        conn.wins.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    conn.duplicates.fetch_add(1, std::memory_order_relaxed);
+
+    const Arrival &winner = arrivals[finalUpdateId % ARRIVAL_HISTORY];
+    if (winner.updateId == finalUpdateId)
+    {
+        auto lag = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - winner.time).count());
+        conn.lagSamples.fetch_add(1, std::memory_order_relaxed);
+        conn.lagNanosTotal.fetch_add(lag, std::memory_order_relaxed);
+        if (lag > conn.lagNanosMax.load(std::memory_order_relaxed))
+        {
+            conn.lagNanosMax.store(lag, std::memory_order_relaxed);
+        }
+    }
+
+    return false;
+}
+
+void FeedArbiter::setConnected(size_t connectionId, bool connected)
+{
+    counters[connectionId]->connected.store(connected);
+}
+
+void FeedArbiter::recordReconnect(size_t connectionId)
+{
+    counters[connectionId]->reconnects.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t FeedArbiter::getConnectionCount() const
+{
+    return counters.size();
+}
+
+std::vector<FeedConnectionStats> FeedArbiter::getStats() const
+{
+    std::vector<FeedConnectionStats> result;
+    result.reserve(counters.size());
+
+    for (size_t i = 0; i < counters.size(); ++i)
+    {
+        const ConnectionCounters &conn = *counters[i];
+
+        FeedConnectionStats stats;
+        stats.connectionId = i;
+        stats.connected = conn.connected.load();
+        stats.messages = conn.messages.load(std::memory_order_relaxed);
+        stats.wins = conn.wins.load(std::memory_order_relaxed);
+        stats.duplicates = conn.duplicates.load(std::memory_order_relaxed);
+        stats.reconnects = conn.reconnects.load(std::memory_order_relaxed);
+
+        uint64_t arbitrated = stats.wins + stats.duplicates;
+        if (arbitrated > 0)
+        {
+            stats.winRate = static_cast<double>(stats.wins) / static_cast<double>(arbitrated);
+        }
+        uint64_t lagSamples = conn.lagSamples.load(std::memory_order_relaxed);
+        if (lagSamples > 0)
+        {
+            stats.avgLagMs = conn.lagNanosTotal.load(std::memory_order_relaxed) / 1e6 / lagSamples;
+        }
+        stats.maxLagMs = conn.lagNanosMax.load(std::memory_order_relaxed) / 1e6;
+
+        result.push_back(stats);
+    }
+
+    return result;
+}
@@ -0,0 +1,309 @@
+#include "HttpEngine.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+namespace
+{
+size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *userdata)
+{
+    size_t totalSize = size * nmemb;
+    static_cast<HttpResponse *>(userdata)->body.append(static_cast<char *>(contents), totalSize);
+    return totalSize;
+}
+
+// Picks up Binance's weight accounting and rate-limit hints
+size_t HeaderCallback(char *buffer, size_t size, size_t nitems, void *userdata)
+{
+    size_t totalSize = size * nitems;
+    HttpResponse *response = static_cast<HttpResponse *>(userdata);
+
+    auto headerValue = [&](const char *name) -> const char * {
+        size_t nameLength = std::strlen(name);
+        if (totalSize > nameLength && strncasecmp(buffer, name, nameLength) == 0)
+        {
+            return buffer + nameLength;
+        }
+        return nullptr;
+    };
+
+    if (const char *value = headerValue("x-mbx-used-weight-1m:"))
+    {
+        response->usedWeight = std::strtol(value, nullptr, 10);
+    }
+    else if (const char *value = headerValue("retry-after:"))
+    {
+        response->retryAfterSeconds = std::strtol(value, nullptr, 10);
+    }
+
+    return totalSize;
+}
+} // namespace
+
+HttpEngine &HttpEngine::instance()
+{
+    static HttpEngine engine;
+    return engine;
+}
+
+HttpEngine::HttpEngine()
+{
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    multi = curl_multi_init();
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, 8L);
+
+    // DNS results and TLS sessions are shared by every handle; only the engine thread touches them
+    share = curl_share_init();
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    running.store(true);
+    engineThread = std::thread(&HttpEngine::eventLoop, this);
+}
+
+HttpEngine::~HttpEngine()
+{
+    running.store(false);
+    curl_multi_wakeup(multi);
+
+    if (engineThread.joinable())
+    {
+        engineThread.join();
+    }
+
+    // The engine thread failed every request before exiting, so only idle handles remain
+    for (CURL *easy : idleHandles)
+    {
+        curl_easy_cleanup(easy);
+    }
+
+    curl_multi_cleanup(multi);
+    curl_share_cleanup(share);
+    curl_global_cleanup();
+}
+
+void HttpEngine::submit(const std::string &url, int weight, Completion completion)
+{
+    auto request = std::make_unique<Request>();
+    request->url = url;
+    request->weight = weight;
+    request->completion = std::move(completion);
+
+    {
+        // Checked under the lock so a request either reaches the final drain or is failed here
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (running.load())
+        {
+            pending.push_back(std::move(request));
+        }
+    }
+
+    if (request)
+    {
+        request->response.error = "HTTP engine stopped";
+        request->completion(std::move(request->response));
+        return;
+    }
+
+    curl_multi_wakeup(multi);
+}
+
+bool HttpEngine::isEngineThread() const
+{
+    return std::this_thread::get_id() == engineThread.get_id();
+}
+
+int HttpEngine::getUsedWeight() const
+{
+    return usedWeight.load();
+}
+
+size_t HttpEngine::getPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return pending.size();
+}
+
+void HttpEngine::eventLoop()
+{
+    while (running.load())
+    {
+        dispatchPending();
+
+        int stillRunning = 0;
+        curl_multi_perform(multi, &stillRunning);
+        completeTransfers();
+
+        // Sleeps until socket activity, a timeout, or submit() wakes us up
+        curl_multi_poll(multi, nullptr, 0, POLL_TIMEOUT_MS, nullptr);
+    }
+
+    failRemaining();
+}
+
+void HttpEngine::failRemaining()
+{
+    // Fail whatever is left, queued or in flight, so no caller waits forever
+    std::vector<std::unique_ptr<Request>> abandoned;
+    for (auto &[easy, request] : inFlight)
+    {
+        curl_multi_remove_handle(multi, easy);
+        releaseHandle(easy);
+        abandoned.push_back(std::move(request));
+    }
+    inFlight.clear();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        for (auto &request : pending)
+        {
+            abandoned.push_back(std::move(request));
+        }
+        pending.clear();
+    }
+
+    for (auto &request : abandoned)
+    {
+        request->response.error = "HTTP engine stopped";
+        request->completion(std::move(request->response));
+    }
+}
+
+void HttpEngine::expireWeightWindow(std::chrono::steady_clock::time_point now)
+{
+    while (!weightWindow.empty() && now - weightWindow.front().time >= std::chrono::minutes(1))
+    {
+        windowWeight -= weightWindow.front().weight;
+        weightWindow.pop_front();
+    }
+}
+
+int HttpEngine::currentWeight(std::chrono::steady_clock::time_point now) const
+{
+    // Binance's own count also covers other clients on this IP, so trust it while it is fresh
+    int serverWeight = now - serverWeightTime < std::chrono::minutes(1) ? static_cast<int>(serverUsedWeight) : 0;
+    return std::max(windowWeight, serverWeight);
+}
+
+void HttpEngine::dispatchPending()
+{
+    auto now = std::chrono::steady_clock::now();
+    expireWeightWindow(now);
+
+    if (now < backoffUntil)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+
+    while (!pending.empty())
+    {
+        Request &next = *pending.front();
+
+        // Hold requests back until the one-minute window has room; a single oversized
+        // request is still let through on an idle window so it cannot starve
+        int weight = currentWeight(now);
+        if (weight > 0 && weight + next.weight > WEIGHT_BUDGET)
+        {
+            break;
+        }
+
+        std::unique_ptr<Request> request = std::move(pending.front());
+        pending.pop_front();
+
+        request->easy = acquireHandle();
+        configureHandle(*request);
+
+        weightWindow.push_back(WeightCharge{now, request->weight});
+        windowWeight += request->weight;
+
+        CURL *easy = request->easy;
+        inFlight.emplace(easy, std::move(request));
+        curl_multi_add_handle(multi, easy);
+    }
+
+    usedWeight.store(currentWeight(now));
+}
+
+void HttpEngine::completeTransfers()
+{
+    int messagesLeft = 0;
+    while (CURLMsg *message = curl_multi_info_read(multi, &messagesLeft))
+    {
+        if (message->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+
+        CURL *easy = message->easy_handle;
+        auto it = inFlight.find(easy);
+        if (it == inFlight.end())
+        {
+            continue;
+        }
+
+        std::unique_ptr<Request> request = std::move(it->second);
+        inFlight.erase(it);
+        curl_multi_remove_handle(multi, easy);
+
+        HttpResponse &response = request->response;
+        if (message->data.result != CURLE_OK)
+        {
+            response.error = curl_easy_strerror(message->data.result);
+        }
+        curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &response.status);
+
+        auto now = std::chrono::steady_clock::now();
+        if (response.usedWeight >= 0)
+        {
+            serverUsedWeight = response.usedWeight;
+            serverWeightTime = now;
+        }
+        if (response.status == 429 || response.status == 418)
+        {
+            long retryAfter = response.retryAfterSeconds > 0 ? response.retryAfterSeconds : 60;
+            backoffUntil = now + std::chrono::seconds(retryAfter);
+        }
+
+        releaseHandle(easy);
+        request->completion(std::move(response));
+    }
+}
+
+CURL *HttpEngine::acquireHandle()
+{
+    if (!idleHandles.empty())
+    {
+        CURL *easy = idleHandles.back();
+        idleHandles.pop_back();
+
+        // Reset options only; live connections and caches stay with the handle and the multi
+        curl_easy_reset(easy);
+        return easy;
+    }
+
+    return curl_easy_init();
+}
+
+void HttpEngine::releaseHandle(CURL *easy)
+{
+    idleHandles.push_back(easy);
+}
+
+void HttpEngine::configureHandle(Request &request)
+{
+    CURL *easy = request.easy;
+    curl_easy_setopt(easy, CURLOPT_URL, request.url.c_str());
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, &request.response);
+    curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, HeaderCallback);
+    curl_easy_setopt(easy, CURLOPT_HEADERDATA, &request.response);
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT, REQUEST_TIMEOUT_S);
+    curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(easy, CURLOPT_SSL_VERIFYPEER, 0L); // Skip SSL verification for simplicity
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(easy, CURLOPT_ACCEPT_ENCODING, "");
+    curl_easy_setopt(easy, CURLOPT_SHARE, share);
+}
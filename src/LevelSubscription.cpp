@@ -0,0 +1,204 @@
+#include "LevelSubscription.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+bool insideHorizon(const LevelChange &change, const DepthHorizon &horizon)
+{
+    // Inside if the price was in the top N before the event or is in it afterwards
+    if (change.side == BookSide::BID)
+    {
+        return std::isnan(horizon.bidBefore) || std::isnan(horizon.bidAfter) ||
+               change.price >= std::min(horizon.bidBefore, horizon.bidAfter);
+    }
+    return std::isnan(horizon.askBefore) || std::isnan(horizon.askAfter) ||
+           change.price <= std::max(horizon.askBefore, horizon.askAfter);
+}
+} // namespace
+
+// LevelSubscription
+
+LevelSubscription::LevelSubscription(const SubscriptionFilter &subscriptionFilter, size_t capacity,
+                                     std::function<void(const LevelChange &)> changeCallback)
+    : filter(subscriptionFilter), ring(capacity), callback(std::move(changeCallback))
+{
+}
+
+bool LevelSubscription::poll(LevelChange &change)
+{
+    return ring.tryPop(change);
+}
+
+uint64_t LevelSubscription::getDropped() const
+{
+    return dropped.load(std::memory_order_relaxed);
+}
+
+const SubscriptionFilter &LevelSubscription::getFilter() const
+{
+    return filter;
+}
+
+// LevelChangeHub
+
+LevelChangeHub::~LevelChangeHub()
+{
+    if (dispatching.exchange(false))
+    {
+        publishedBatches.fetch_add(1, std::memory_order_release);
+        publishedBatches.notify_all();
+        dispatcher.join();
+    }
+}
+
+SubscriptionHandle LevelChangeHub::subscribe(const SubscriptionFilter &filter,
+                                             std::function<void(const LevelChange &)> callback, size_t capacity)
+{
+    auto subscription = std::make_shared<LevelSubscription>(filter, capacity, std::move(callback));
+
+    std::lock_guard<std::mutex> lock(subscribeMutex);
+
+    Subscribers current = subscribers.load();
+    std::vector<SubscriptionHandle> subscriptions;
+    if (current)
+    {
+        subscriptions = current->subscriptions;
+    }
+    subscriptions.push_back(subscription);
+    replaceSubscribers(std::move(subscriptions));
+
+    // The dispatcher starts with the first callback subscription; polled ones never need it
+    if (subscription->callback && !dispatching.exchange(true))
+    {
+        dispatcher = std::thread(&LevelChangeHub::dispatchLoop, this);
+    }
+    return subscription;
+}
+
+SubscriptionHandle LevelChangeHub::subscribe(const SubscriptionFilter &filter, size_t capacity)
+{
+    return subscribe(filter, nullptr, capacity);
+}
+
+void LevelChangeHub::unsubscribe(const SubscriptionHandle &subscription)
+{
+    std::lock_guard<std::mutex> lock(subscribeMutex);
+
+    Subscribers current = subscribers.load();
+    if (!current)
+    {
+        return;
+    }
+
+    std::vector<SubscriptionHandle> subscriptions = current->subscriptions;
+    subscriptions.erase(std::remove(subscriptions.begin(), subscriptions.end(), subscription), subscriptions.end());
+    replaceSubscribers(std::move(subscriptions));
+}
+
+void LevelChangeHub::replaceSubscribers(std::vector<SubscriptionHandle> subscriptions)
+{
+    if (subscriptions.empty())
+    {
+        anySubscribers.store(false);
+        subscribers.store(nullptr);
+        return;
+    }
+
+    auto list = std::make_shared<SubscriberList>();
+    list->subscriptions = std::move(subscriptions);
+
+    for (const auto &subscription : list->subscriptions)
+    {
+        size_t depth = subscription->filter.topLevels;
+        size_t slot = 0;
+        if (depth > 0)
+        {
+            auto existing = std::find(list->depths.begin(), list->depths.end(), depth);
+            slot = existing - list->depths.begin();
+            if (existing == list->depths.end())
+            {
+                list->depths.push_back(depth);
+            }
+        }
+        list->horizonSlots.push_back(slot);
+        list->hasCallbacks = list->hasCallbacks || static_cast<bool>(subscription->callback);
+    }
+
+    subscribers.store(std::move(list));
+    anySubscribers.store(true);
+}
+
+LevelChangeHub::Subscribers LevelChangeHub::getSubscribers() const
+{
+    // Skip the shared_ptr load on the common path with nobody listening
+    if (!anySubscribers.load(std::memory_order_acquire))
+    {
+        return nullptr;
+    }
+    return subscribers.load();
+}
+
+void LevelChangeHub::publish(const SubscriberList &list, const std::vector<LevelChange> &changes,
+                             const std::vector<DepthHorizon> &horizons)
+{
+    for (size_t i = 0; i < list.subscriptions.size(); ++i)
+    {
+        LevelSubscription &subscription = *list.subscriptions[i];
+        const SubscriptionFilter &filter = subscription.filter;
+
+        for (const LevelChange &change : changes)
+        {
+            bool replaced = change.flags & LevelChangeFlags::BOOK_REPLACED;
+            if (!replaced)
+            {
+                if (filter.bboOnly && !(change.flags & LevelChangeFlags::AT_BBO))
+                    continue;
+                if (filter.topLevels > 0 && !insideHorizon(change, horizons[list.horizonSlots[i]]))
+                    continue;
+            }
+
+            if (!subscription.ring.tryPush(change))
+            {
+                subscription.dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    if (list.hasCallbacks)
+    {
+        publishedBatches.fetch_add(1, std::memory_order_release);
+        publishedBatches.notify_one();
+    }
+}
+
+void LevelChangeHub::dispatchLoop()
+{
+    uint64_t seen = 0;
+    LevelChange change;
+
+    while (dispatching.load())
+    {
+        // Sleeps in the kernel until the publisher bumps the counter
+        publishedBatches.wait(seen, std::memory_order_acquire);
+        seen = publishedBatches.load(std::memory_order_acquire);
+
+        Subscribers list = subscribers.load();
+        if (!list)
+        {
+            continue;
+        }
+
+        for (const auto &subscription : list->subscriptions)
+        {
+            if (!subscription->callback)
+            {
+                continue;
+            }
+            while (subscription->ring.tryPop(change))
+            {
+                subscription->callback(change);
+            }
+        }
+    }
+}
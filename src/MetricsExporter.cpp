@@ -0,0 +1,279 @@
+#include "MetricsExporter.h"
+#include "HttpEngine.h"
+#include "OrderBookSynchronizer.h"
+#include <sstream>
+
+namespace
+{
+void writeHeader(std::ostringstream &out, const char *name, const char *type, const char *help)
+{
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " " << type << "\n";
+}
+} // namespace
+
+MetricsExporter::MetricsExporter() : acceptor(ioContext)
+{
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+void MetricsExporter::addSource(const std::string &symbol, const OrderBookSynchronizer *synchronizer,
+                                std::function<std::vector<FeedConnectionStats>()> feedStats)
+{
+    std::lock_guard<std::mutex> lock(sourcesMutex);
+
+    Source source;
+    source.symbol = symbol;
+    source.synchronizer = synchronizer;
+    source.feedStats = std::move(feedStats);
+    source.lastScrape = std::chrono::steady_clock::now();
+    sources.push_back(std::move(source));
+}
+
+void MetricsExporter::removeSource(const std::string &symbol)
+{
+    std::lock_guard<std::mutex> lock(sourcesMutex);
+    std::erase_if(sources, [&symbol](const Source &source) { return source.symbol == symbol; });
+}
+
+bool MetricsExporter::start(unsigned short port)
+{
+    if (running)
+    {
+        return true;
+    }
+
+    boost::system::error_code ec;
+    boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::make_address("127.0.0.1"), port);
+
+    acceptor.open(endpoint.protocol(), ec);
+    if (!ec)
+        acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true), ec);
+    if (!ec)
+        acceptor.bind(endpoint, ec);
+    if (!ec)
+        acceptor.listen(boost::asio::socket_base::max_listen_connections, ec);
+
+    if (ec)
+    {
+        acceptor.close(ec);
+        return false;
+    }
+
+    running = true;
+    acceptNext();
+    serverThread = std::thread([this]() { ioContext.run(); });
+    return true;
+}
+
+void MetricsExporter::stop()
+{
+    if (!running)
+    {
+        return;
+    }
+
+    running = false;
+    ioContext.stop();
+
+    if (serverThread.joinable())
+    {
+        serverThread.join();
+    }
+
+    boost::system::error_code ec;
+    acceptor.close(ec);
+}
+
+void MetricsExporter::acceptNext()
+{
+    auto socket = std::make_shared<boost::asio::ip::tcp::socket>(ioContext);
+    acceptor.async_accept(*socket, [this, socket](const boost::system::error_code &ec) {
+        if (!ec)
+        {
+            handleConnection(socket);
+        }
+        if (acceptor.is_open())
+        {
+            acceptNext();
+        }
+    });
+}
+
+void MetricsExporter::handleConnection(std::shared_ptr<boost::asio::ip::tcp::socket> socket)
+{
+    auto request = std::make_shared<boost::asio::streambuf>();
+    boost::asio::async_read_until(
+        *socket, *request, "\r\n\r\n", [this, socket, request](const boost::system::error_code &ec, size_t) {
+            if (ec)
+            {
+                return;
+            }
+
+            std::istream stream(request.get());
+            std::string method;
+            std::string path;
+            stream >> method >> path;
+
+            auto response = std::make_shared<std::string>();
+            if (method == "GET" && (path == "/metrics" || path == "/"))
+            {
+                std::string body = render();
+                *response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                            std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+            }
+            else
+            {
+                *response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            }
+
+            boost::asio::async_write(*socket, boost::asio::buffer(*response),
+                                     [socket, response](const boost::system::error_code &, size_t) {
+                                         boost::system::error_code ignored;
+                                         socket->shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored);
+                                     });
+        });
+}
+
+std::string MetricsExporter::render()
+{
+    std::lock_guard<std::mutex> lock(sourcesMutex);
+    std::ostringstream out;
+    auto now = std::chrono::steady_clock::now();
+
+    // Counters
+    struct CounterMetric
+    {
+        const char *name;
+        const char *help;
+        const ShardedCounter SyncMetrics::*member;
+    };
+    static const CounterMetric counters[] = {
+        {"orderbook_messages_total", "Depth frames received across all replicas", &SyncMetrics::messages},
+        {"orderbook_parse_failures_total", "Frames that failed to parse", &SyncMetrics::parseFailures},
+        {"orderbook_gaps_total", "Sequence gaps detected while synchronized", &SyncMetrics::gaps},
+        {"orderbook_resyncs_total", "Resyncs from a fresh snapshot", &SyncMetrics::resyncs},
+        {"orderbook_buffer_restarts_total", "Sync buffers restarted at a gap in the buffered stream",
+         &SyncMetrics::bufferRestarts},
+        {"orderbook_audits_total", "Drift audits against a REST snapshot", &SyncMetrics::audits},
+        {"orderbook_audit_divergences_total", "Audits that found the book had drifted",
+         &SyncMetrics::auditDivergences},
+    };
+
+    for (const auto &counter : counters)
+    {
+        writeHeader(out, counter.name, "counter", counter.help);
+        for (const auto &source : sources)
+        {
+            out << counter.name << "{symbol=\"" << source.symbol << "\"} "
+                << (source.synchronizer->getMetrics().*counter.member).load() << "\n";
+        }
+    }
+
+    writeHeader(out, "orderbook_resync_duration_seconds_total", "counter", "Total time spent resynchronizing");
+    for (const auto &source : sources)
+    {
+        out << "orderbook_resync_duration_seconds_total{symbol=\"" << source.symbol << "\"} "
+            << source.synchronizer->getMetrics().resyncDurationTotalNs.load() / 1e9 << "\n";
+    }
+
+    // Gauges
+    writeHeader(out, "orderbook_messages_per_second", "gauge", "Depth frames per second since the previous scrape");
+    for (auto &source : sources)
+    {
+        uint64_t messages = source.synchronizer->getMetrics().messages.load();
+        double elapsed = std::chrono::duration<double>(now - source.lastScrape).count();
+        double rate = elapsed > 0.0 ? (messages - source.lastMessages) / elapsed : 0.0;
+        source.lastMessages = messages;
+        source.lastScrape = now;
+        out << "orderbook_messages_per_second{symbol=\"" << source.symbol << "\"} " << rate << "\n";
+    }
+
+    writeHeader(out, "orderbook_last_resync_duration_seconds", "gauge", "Duration of the most recent resync");
+    for (const auto &source : sources)
+    {
+        out << "orderbook_last_resync_duration_seconds{symbol=\"" << source.symbol << "\"} "
+            << source.synchronizer->getMetrics().lastResyncDurationNs.load() / 1e9 << "\n";
+    }
+
+    writeHeader(out, "orderbook_buffer_occupancy", "gauge", "Price levels waiting in the sync buffer");
+    for (const auto &source : sources)
+    {
+        out << "orderbook_buffer_occupancy{symbol=\"" << source.symbol << "\"} "
+            << source.synchronizer->getMetrics().bufferOccupancy.load() << "\n";
+    }
+
+    writeHeader(out, "orderbook_sync_state", "gauge", "1 for the current synchronizer state");
+    for (const auto &source : sources)
+    {
+        std::string current = source.synchronizer->getStateString();
+        for (const char *state : {"INITIALIZING", "BUFFERING", "SNAPSHOT_RECEIVED", "SYNCHRONIZED", "ERROR_STATE"})
+        {
+            out << "orderbook_sync_state{symbol=\"" << source.symbol << "\",state=\"" << state << "\"} "
+                << (current == state ? 1 : 0) << "\n";
+        }
+    }
+
+    writeHeader(out, "orderbook_update_id_lag", "gauge", "Latest received update id minus the applied update id");
+    for (const auto &source : sources)
+    {
+        long long received = source.synchronizer->getMetrics().latestReceivedUpdateId.load();
+        long long applied = source.synchronizer->getLocalUpdateId();
+        out << "orderbook_update_id_lag{symbol=\"" << source.symbol << "\"} "
+            << (received > applied ? received - applied : 0) << "\n";
+    }
+
+    writeHeader(out, "orderbook_sync_loop_lag_seconds", "gauge", "Background sync loop wake-up delay");
+    for (const auto &source : sources)
+    {
+        out << "orderbook_sync_loop_lag_seconds{symbol=\"" << source.symbol << "\"} "
+            << source.synchronizer->getMetrics().loopLagNs.load() / 1e9 << "\n";
+    }
+
+    // Redundant feed arbitration; samples of one metric family must stay together
+    std::vector<std::pair<const Source *, std::vector<FeedConnectionStats>>> feeds;
+    for (const auto &source : sources)
+    {
+        if (source.feedStats)
+        {
+            feeds.emplace_back(&source, source.feedStats());
+        }
+    }
+
+    struct FeedMetric
+    {
+        const char *name;
+        const char *help;
+        double (*value)(const FeedConnectionStats &);
+    };
+    static const FeedMetric feedMetrics[] = {
+        {"orderbook_feed_win_rate", "Share of updates a replica delivered first",
+         [](const FeedConnectionStats &feed) { return feed.winRate; }},
+        {"orderbook_feed_lag_seconds", "Average delay of a replica behind the winning copy",
+         [](const FeedConnectionStats &feed) { return feed.avgLagMs / 1e3; }},
+        {"orderbook_feed_connected", "1 while the replica connection is open",
+         [](const FeedConnectionStats &feed) { return feed.connected ? 1.0 : 0.0; }},
+    };
+
+    for (const auto &metric : feedMetrics)
+    {
+        writeHeader(out, metric.name, "gauge", metric.help);
+        for (const auto &[source, stats] : feeds)
+        {
+            for (const auto &feed : stats)
+            {
+                out << metric.name << "{symbol=\"" << source->symbol << "\",replica=\"" << feed.connectionId << "\"} "
+                    << metric.value(feed) << "\n";
+            }
+        }
+    }
+
+    writeHeader(out, "orderbook_http_used_weight", "gauge", "Binance request weight used in the current minute");
+    out << "orderbook_http_used_weight " << HttpEngine::instance().getUsedWeight() << "\n";
+
+    return out.str();
+}
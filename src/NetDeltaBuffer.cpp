@@ -0,0 +1,101 @@
+#include "NetDeltaBuffer.h"
+
+void NetDeltaBuffer::foldSide(std::map<double, Entry> &side, const DepthLevels &levels, long long updateId)
+{
+    for (const auto &[price, quantity] : levels)
+    {
+        side.insert_or_assign(price, Entry{quantity, updateId});
+    }
+}
+
+void NetDeltaBuffer::extractSide(const std::map<double, Entry> &side, long long afterId, DepthLevels &out)
+{
+    out.clear();
+    for (const auto &[price, entry] : side)
+    {
+        // Writes at or before the snapshot are already in it, and nothing later touched the price
+        if (entry.updateId > afterId)
+        {
+            out.emplace_back(price, entry.quantity);
+        }
+    }
+}
+
+NetDeltaBuffer::FoldResult NetDeltaBuffer::fold(const DepthEvent &event)
+{
+    FoldResult result = FoldResult::FOLDED;
+    if (eventCount > 0)
+    {
+        if (event.finalUpdateId <= finalUpdateId)
+        {
+            return FoldResult::DUPLICATE;
+        }
+
+        // A gap means the run before it can never be applied in sequence; start over from here
+        if (event.firstUpdateId > finalUpdateId + 1)
+        {
+            clear();
+            result = FoldResult::RESTARTED;
+        }
+    }
+
+    if (eventCount == 0)
+    {
+        firstUpdateId = event.firstUpdateId;
+    }
+    finalUpdateId = event.finalUpdateId;
+    eventCount++;
+    lastTimestamp = event.timestamp;
+
+    foldSide(bids, event.bids, event.finalUpdateId);
+    foldSide(asks, event.asks, event.finalUpdateId);
+    return result;
+}
+
+bool NetDeltaBuffer::reaches(long long lastUpdateId) const
+{
+    return eventCount > 0 && firstUpdateId <= lastUpdateId + 1 && finalUpdateId >= lastUpdateId + 1;
+}
+
+void NetDeltaBuffer::extractAfter(long long lastUpdateId, DepthEvent &out) const
+{
+    out.firstUpdateId = lastUpdateId + 1;
+    out.finalUpdateId = finalUpdateId;
+    out.timestamp = lastTimestamp;
+    extractSide(bids, lastUpdateId, out.bids);
+    extractSide(asks, lastUpdateId, out.asks);
+}
+
+void NetDeltaBuffer::clear()
+{
+    bids.clear();
+    asks.clear();
+    firstUpdateId = 0;
+    finalUpdateId = 0;
+    eventCount = 0;
+}
+
+bool NetDeltaBuffer::empty() const
+{
+    return eventCount == 0;
+}
+
+size_t NetDeltaBuffer::getLevelCount() const
+{
+    return bids.size() + asks.size();
+}
+
+size_t NetDeltaBuffer::getEventCount() const
+{
+    return eventCount;
+}
+
+long long NetDeltaBuffer::getFirstUpdateId() const
+{
+    return firstUpdateId;
+}
+
+long long NetDeltaBuffer::getFinalUpdateId() const
+{
+    return finalUpdateId;
+}
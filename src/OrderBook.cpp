@@ -1,4 +1,7 @@
 #include "OrderBook.h"
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
 
 void signalHandler(int signal)
 {
@@ -10,31 +13,72 @@ void signalHandler(int signal)
 
 std::atomic<bool> g_running(true);
 
+SymbolConfig OrderBook::configFromEnvironment(const std::string &tradingSymbol)
+{
+    SymbolConfig config;
+
+    // Optional bounded-depth mode for this symbol
+    if (const char *maxLevels = std::getenv("ORDERBOOK_MAX_LEVELS"))
+    {
+        config.depthBound.maxLevels = std::strtoul(maxLevels, nullptr, 10);
+    }
+    if (const char *maxDistancePct = std::getenv("ORDERBOOK_MAX_DISTANCE_PCT"))
+    {
+        config.depthBound.maxDistancePct = std::strtod(maxDistancePct, nullptr);
+    }
+
+    // Bucketed views behind the UI zoom levels
+    config.aggregationTicks.assign(OrderBookUI::ZOOM_TICKS.begin(), OrderBookUI::ZOOM_TICKS.end());
+
+    // Warm start from the last persisted book for this symbol
+    const char *checkpointDir = std::getenv("ORDERBOOK_CHECKPOINT_DIR");
+    config.checkpointPath = std::string(checkpointDir ? checkpointDir : "checkpoints") + "/" + tradingSymbol + ".book";
+
+    // Journal applied deltas when a journal directory is configured
+    if (const char *journalDir = std::getenv("ORDERBOOK_JOURNAL_DIR"))
+    {
+        config.journalDirectory = std::string(journalDir) + "/" + tradingSymbol;
+    }
+
+    // Rolling depth history behind the heatmap; ORDERBOOK_HISTORY_SECONDS=0 turns it off
+    const char *historySeconds = std::getenv("ORDERBOOK_HISTORY_SECONDS");
+    config.history.horizonSeconds = historySeconds ? std::strtoll(historySeconds, nullptr, 10) : 300;
+    config.recordHistory = config.history.horizonSeconds > 0;
+
+    // Periodic drift audit against a REST snapshot; ORDERBOOK_AUDIT_SECONDS=0 turns it off
+    const char *auditSeconds = std::getenv("ORDERBOOK_AUDIT_SECONDS");
+    config.auditIntervalSeconds = auditSeconds ? std::atoi(auditSeconds) : 600;
+    return config;
+}
+
 OrderBook::OrderBook(const std::string &tradingSymbol)
-    : symbol(tradingSymbol), synchronizer(tradingSymbol), ws(avgPrice, orderBookManager, synchronizer, tradingSymbol),
-      ui(avgPrice, orderBookManager, tradingSymbol)
+    : symbol(tradingSymbol), synchronizer(engine.addSymbol(tradingSymbol, configFromEnvironment(tradingSymbol))),
+      ui(*engine.getAveragePrice(tradingSymbol), orderBookManager, tradingSymbol)
 {
     orderBookManager.setSynchronizer(&synchronizer);
-
-    // Set up update callback from synchronizer to UI
-    // synchronizer.setUpdateCallback([this]() {});
+    ui.setFeedStatsProvider([this]() { return engine.getFeedStats(symbol); });
+    ui.setDepthHistory(engine.getDepthHistory(symbol));
 }
 
 void OrderBook::run()
 {
-    synchronizer.start();
-    ws.start();
+    engine.start();
+
+    // Prometheus endpoint; the exporter stays off if the port is taken
+    const char *metricsPort = std::getenv("ORDERBOOK_METRICS_PORT");
+    engine.startMetrics(metricsPort ? static_cast<unsigned short>(std::strtoul(metricsPort, nullptr, 10))
+                                      : DEFAULT_METRICS_PORT);
 
-    // Wait for synchronization with progress updates
+    // Wait for synchronization with progress updates; a warm (stale) book can be shown at once
     for (int i = 0; i < 30; i++)
     {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-
-        if (synchronizer.isSynchronized())
+        if (synchronizer.isSynchronized() || synchronizer.isStale())
         {
             break;
         }
 
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+
         if (i == 29)
         {
         }
@@ -42,6 +86,9 @@ void OrderBook::run()
 
     ui.start();
 
-    ws.stop();
-    synchronizer.stop();
+    engine.stop();
+
+#ifdef ORDERBOOK_LOCK_PROFILING
+    LockProfiler::instance().writeReport(std::cerr);
+#endif
 }
@@ -1,7 +1,69 @@
 #include "OrderBookData.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <numeric>
 
-OrderBookData::OrderBookData() : lastUpdateId_(0)
+namespace
 {
+// Levels sampled from each side when inferring the tick size
+constexpr size_t TICK_SAMPLE_LEVELS = 100;
+
+// Binance prices carry at most 8 decimals, so every gap is a whole number of these
+constexpr double PRICE_QUANTUM = 1e-8;
+
+// Float slack so a price sitting exactly on a bucket edge is not pushed into the next bucket
+constexpr double BUCKET_EPSILON = 1e-9;
+
+// Relative slack on a bps limit, so a level sitting on it counts on both the index and map paths
+constexpr double LIMIT_EPSILON = 1e-9;
+
+template <typename BucketMap> void adjustBucket(BucketMap &buckets, int64_t index, double oldQuantity, double newQuantity)
+{
+    if (oldQuantity == 0.0 && newQuantity == 0.0)
+    {
+        return;
+    }
+
+    AggregationBucket &bucket = buckets[index];
+    bucket.quantity += newQuantity - oldQuantity;
+    if (oldQuantity == 0.0)
+    {
+        bucket.levels++;
+    }
+    else if (newQuantity == 0.0 && --bucket.levels == 0)
+    {
+        buckets.erase(index);
+    }
+}
+
+int64_t bidBucket(const AggregationView &view, double price)
+{
+    return static_cast<int64_t>(std::floor(price / view.bucketSize + BUCKET_EPSILON));
+}
+
+int64_t askBucket(const AggregationView &view, double price)
+{
+    return static_cast<int64_t>(std::ceil(price / view.bucketSize - BUCKET_EPSILON));
+}
+
+// Greatest common divisor of the gaps between adjacent levels, in price quanta
+template <typename Map> int64_t gapDivisor(const Map &side, int64_t divisor)
+{
+    auto it = side.begin();
+    for (size_t i = 1; i < TICK_SAMPLE_LEVELS && it != side.end() && std::next(it) != side.end(); ++i, ++it)
+    {
+        divisor = std::gcd(divisor, std::llround(std::abs(std::next(it)->first - it->first) / PRICE_QUANTUM));
+    }
+    return divisor;
+}
+} // namespace
+
+OrderBookData::OrderBookData()
+    : lastUpdateId_(0), tickSize_(0.0), tickSizeFixed_(false), indexTicks_(0), bidIndex_(true), askIndex_(false)
+{
+    resetCoverage();
 }
 
 const BidsMap &OrderBookData::getBids() const
@@ -34,6 +96,425 @@ void OrderBookData::setLastUpdateId(long long id)
     lastUpdateId_ = id;
 }
 
+void OrderBookData::resetCoverage()
+{
+    bidFloor_ = std::numeric_limits<double>::lowest();
+    askCeiling_ = std::numeric_limits<double>::max();
+}
+
+bool OrderBookData::setBid(double price, double quantity)
+{
+    if (price <= bidFloor_)
+    {
+        return false;
+    }
+
+    auto it = bids_.find(price);
+    double oldQuantity = it != bids_.end() ? it->second : 0.0;
+
+    if (quantity == 0.0)
+    {
+        if (it != bids_.end())
+            bids_.erase(it);
+    }
+    else if (it != bids_.end())
+    {
+        it->second = quantity;
+    }
+    else
+    {
+        bids_.emplace(price, quantity);
+    }
+
+    updateViews(true, price, oldQuantity, quantity);
+    updateIndex(true, price, oldQuantity, quantity);
+    return true;
+}
+
+bool OrderBookData::setAsk(double price, double quantity)
+{
+    if (price >= askCeiling_)
+    {
+        return false;
+    }
+
+    auto it = asks_.find(price);
+    double oldQuantity = it != asks_.end() ? it->second : 0.0;
+
+    if (quantity == 0.0)
+    {
+        if (it != asks_.end())
+            asks_.erase(it);
+    }
+    else if (it != asks_.end())
+    {
+        it->second = quantity;
+    }
+    else
+    {
+        asks_.emplace(price, quantity);
+    }
+
+    updateViews(false, price, oldQuantity, quantity);
+    updateIndex(false, price, oldQuantity, quantity);
+    return true;
+}
+
+void OrderBookData::eraseBid(BidsMap::iterator it)
+{
+    auto [price, quantity] = *it;
+    updateViews(true, price, quantity, 0.0);
+    bids_.erase(it);
+    updateIndex(true, price, quantity, 0.0);
+}
+
+void OrderBookData::eraseAsk(AsksMap::iterator it)
+{
+    auto [price, quantity] = *it;
+    updateViews(false, price, quantity, 0.0);
+    asks_.erase(it);
+    updateIndex(false, price, quantity, 0.0);
+}
+
+void OrderBookData::replaceLevels(const BidsMap &bids, const AsksMap &asks, long long updateId)
+{
+    bids_ = bids;
+    asks_ = asks;
+    lastUpdateId_ = updateId;
+    resetCoverage();
+    inferTickSize();
+    rebuildViews();
+    rebuildIndex();
+    enforceDepthBound();
+}
+
+void OrderBookData::setDepthBound(const DepthBound &bound)
+{
+    bound_ = bound;
+    enforceDepthBound();
+}
+
+const DepthBound &OrderBookData::getDepthBound() const
+{
+    return bound_;
+}
+
+size_t OrderBookData::getLevelCapacity() const
+{
+    return bound_.maxLevels * BOUND_SLACK_FACTOR;
+}
+
+void OrderBookData::enforceDepthBound(std::vector<PrunedLevel> *pruned)
+{
+    if (!bound_.isBounded())
+    {
+        return;
+    }
+
+    // Drop the worst levels; everything from the dropped price outward becomes unknown
+    if (bound_.maxLevels > 0)
+    {
+        size_t capacity = getLevelCapacity();
+        while (bids_.size() > capacity)
+        {
+            auto worst = std::prev(bids_.end());
+            bidFloor_ = std::max(bidFloor_, worst->first);
+            if (pruned)
+                pruned->push_back({true, worst->first});
+            eraseBid(worst);
+        }
+        while (asks_.size() > capacity)
+        {
+            auto worst = std::prev(asks_.end());
+            askCeiling_ = std::min(askCeiling_, worst->first);
+            if (pruned)
+                pruned->push_back({false, worst->first});
+            eraseAsk(worst);
+        }
+    }
+
+    if (bound_.maxDistancePct > 0.0 && !bids_.empty() && !asks_.empty())
+    {
+        double mid = (bids_.begin()->first + asks_.begin()->first) / 2.0;
+        double distance = bound_.maxDistancePct * BOUND_SLACK_FACTOR / 100.0;
+        double lowestBid = mid * (1.0 - distance);
+        double highestAsk = mid * (1.0 + distance);
+
+        while (!bids_.empty() && std::prev(bids_.end())->first < lowestBid)
+        {
+            auto worst = std::prev(bids_.end());
+            bidFloor_ = std::max(bidFloor_, worst->first);
+            if (pruned)
+                pruned->push_back({true, worst->first});
+            eraseBid(worst);
+        }
+        while (!asks_.empty() && std::prev(asks_.end())->first > highestAsk)
+        {
+            auto worst = std::prev(asks_.end());
+            askCeiling_ = std::min(askCeiling_, worst->first);
+            if (pruned)
+                pruned->push_back({false, worst->first});
+            eraseAsk(worst);
+        }
+    }
+}
+
+bool OrderBookData::needsRefill() const
+{
+    if (!bound_.isBounded())
+    {
+        return false;
+    }
+
+    bool bidsTruncated = bidFloor_ != std::numeric_limits<double>::lowest();
+    bool asksTruncated = askCeiling_ != std::numeric_limits<double>::max();
+
+    // The book drifted towards a side we pruned, so the known levels no longer cover the bound
+    if (bound_.maxLevels > 0)
+    {
+        if ((bidsTruncated && bids_.size() < bound_.maxLevels) || (asksTruncated && asks_.size() < bound_.maxLevels))
+        {
+            return true;
+        }
+    }
+
+    if (bound_.maxDistancePct > 0.0 && !bids_.empty() && !asks_.empty())
+    {
+        double mid = (bids_.begin()->first + asks_.begin()->first) / 2.0;
+        double distance = bound_.maxDistancePct / 100.0;
+        if ((bidsTruncated && bidFloor_ >= mid * (1.0 - distance)) ||
+            (asksTruncated && askCeiling_ <= mid * (1.0 + distance)))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void OrderBookData::setTickSize(double tickSize)
+{
+    tickSize_ = tickSize;
+    tickSizeFixed_ = tickSize > 0.0;
+    rebuildViews();
+    rebuildIndex();
+}
+
+double OrderBookData::getTickSize() const
+{
+    return tickSize_;
+}
+
+void OrderBookData::inferTickSize()
+{
+    if (tickSizeFixed_)
+    {
+        return;
+    }
+
+    // Every gap is a whole number of ticks, so their common divisor is the tick unless the sample
+    // happens to skip every other tick; PRICE_FILTER from exchangeInfo is exact and set when known
+    int64_t divisor = gapDivisor(asks_, gapDivisor(bids_, 0));
+    if (divisor > 0)
+    {
+        tickSize_ = static_cast<double>(divisor) * PRICE_QUANTUM;
+    }
+}
+
+void OrderBookData::addAggregationView(size_t ticks)
+{
+    for (const auto &view : views_)
+    {
+        if (view.ticks == ticks)
+        {
+            return;
+        }
+    }
+
+    AggregationView view;
+    view.ticks = ticks;
+    views_.push_back(std::move(view));
+    rebuildViews();
+}
+
+void OrderBookData::rebuildViews()
+{
+    for (auto &view : views_)
+    {
+        view.bucketSize = view.ticks * tickSize_;
+        view.bids.clear();
+        view.asks.clear();
+    }
+
+    if (tickSize_ <= 0.0)
+    {
+        return;
+    }
+
+    for (const auto &[price, quantity] : bids_)
+    {
+        updateViews(true, price, 0.0, quantity);
+    }
+    for (const auto &[price, quantity] : asks_)
+    {
+        updateViews(false, price, 0.0, quantity);
+    }
+}
+
+void OrderBookData::updateViews(bool isBid, double price, double oldQuantity, double newQuantity)
+{
+    for (auto &view : views_)
+    {
+        if (view.bucketSize <= 0.0)
+        {
+            continue;
+        }
+
+        if (isBid)
+            adjustBucket(view.bids, bidBucket(view, price), oldQuantity, newQuantity);
+        else
+            adjustBucket(view.asks, askBucket(view, price), oldQuantity, newQuantity);
+    }
+}
+
+void OrderBookData::setDepthIndex(size_t ticks)
+{
+    indexTicks_ = ticks;
+    rebuildIndex();
+}
+
+void OrderBookData::rebuildIndex()
+{
+    // Resizing only allocates when the window changes; otherwise the trees are reused
+    bidIndex_.configure(indexTicks_, tickSize_);
+    askIndex_.configure(indexTicks_, tickSize_);
+    bidIndex_.rebuild(bids_);
+    askIndex_.rebuild(asks_);
+}
+
+void OrderBookData::updateIndex(bool isBid, double price, double oldQuantity, double newQuantity)
+{
+    // Called after the map changed, so a rebuild sees the new level
+    if (isBid)
+    {
+        if (!bidIndex_.update(price, oldQuantity, newQuantity) ||
+            (!bids_.empty() && bidIndex_.isDrifted(bids_.begin()->first)))
+        {
+            bidIndex_.rebuild(bids_);
+        }
+    }
+    else
+    {
+        if (!askIndex_.update(price, oldQuantity, newQuantity) ||
+            (!asks_.empty() && askIndex_.isDrifted(asks_.begin()->first)))
+        {
+            askIndex_.rebuild(asks_);
+        }
+    }
+}
+
+namespace
+{
+template <typename Map>
+void walkFill(const Map &side, typename Map::const_iterator it, double target, FillEstimate &fill)
+{
+    for (; it != side.end() && fill.quantity < target; ++it)
+    {
+        double take = std::min(it->second, target - fill.quantity);
+        fill.quantity += take;
+        fill.notional += take * it->first;
+        fill.worstPrice = it->first;
+    }
+}
+
+template <typename Map> FillEstimate estimateSideFill(const Map &side, const DepthIndex &index, double target)
+{
+    FillEstimate fill;
+    if (target <= 0.0 || side.empty())
+    {
+        return fill;
+    }
+
+    if (!index.isReady())
+    {
+        walkFill(side, side.begin(), target, fill);
+    }
+    else
+    {
+        DepthSum before;
+        size_t slot = index.lowerBound(target, before);
+        if (slot < index.getCapacity())
+        {
+            // Reached inside the window: the rest comes from the level at that slot
+            auto level = side.lower_bound(index.nearEdgeOfSlot(static_cast<int64_t>(slot)));
+            double price = level != side.end() ? level->first : index.priceOfSlot(static_cast<int64_t>(slot));
+            fill.quantity = target;
+            fill.notional = before.notional + (target - before.quantity) * price;
+            fill.worstPrice = price;
+        }
+        else
+        {
+            // The whole window falls short; carry on level by level past it
+            auto past = side.lower_bound(index.nearEdgeOfSlot(static_cast<int64_t>(slot)));
+            fill.quantity = before.quantity;
+            fill.notional = before.notional;
+            fill.worstPrice = past != side.begin() ? std::prev(past)->first : 0.0;
+            walkFill(side, past, target, fill);
+        }
+    }
+
+    fill.averagePrice = fill.quantity > 0.0 ? fill.notional / fill.quantity : 0.0;
+    return fill;
+}
+
+template <typename Map, typename Within>
+DepthSum sumSideWithin(const Map &side, const DepthIndex &index, double limitPrice, Within within)
+{
+    DepthSum sum;
+    auto it = side.begin();
+    if (index.isReady())
+    {
+        int64_t slots = index.slotsWithin(limitPrice);
+        int64_t capacity = static_cast<int64_t>(index.getCapacity());
+        sum = index.prefix(static_cast<size_t>(std::clamp<int64_t>(slots, 0, capacity)));
+        if (slots <= capacity)
+        {
+            return sum;
+        }
+        it = side.lower_bound(index.nearEdgeOfSlot(capacity));
+    }
+
+    for (; it != side.end() && within(it->first); ++it)
+    {
+        sum.quantity += it->second;
+        sum.notional += it->first * it->second;
+    }
+    return sum;
+}
+} // namespace
+
+FillEstimate OrderBookData::estimateFill(bool bidSide, double quantity) const
+{
+    return bidSide ? estimateSideFill(bids_, bidIndex_, quantity) : estimateSideFill(asks_, askIndex_, quantity);
+}
+
+DepthSum OrderBookData::depthWithinBps(bool bidSide, double bps) const
+{
+    if (bids_.empty() || asks_.empty())
+    {
+        return {};
+    }
+
+    double mid = (bids_.begin()->first + asks_.begin()->first) / 2.0;
+    if (bidSide)
+    {
+        double limit = mid * (1.0 - bps / 10000.0) * (1.0 - LIMIT_EPSILON);
+        return sumSideWithin(bids_, bidIndex_, limit, [limit](double price) { return price >= limit; });
+    }
+    double limit = mid * (1.0 + bps / 10000.0) * (1.0 + LIMIT_EPSILON);
+    return sumSideWithin(asks_, askIndex_, limit, [limit](double price) { return price <= limit; });
+}
+
 std::vector<OrderBookLevel> OrderBookData::getTopBids(int levels) const
 {
     std::vector<OrderBookLevel> result;
@@ -62,9 +543,131 @@ std::vector<OrderBookLevel> OrderBookData::getTopAsks(int levels) const
     return result;
 }
 
+namespace
+{
+// First row of a window: the anchor's entry, or the touch when there is none, moved by `scroll` entries.
+// A window never starts so deep that fewer than `page` entries follow it while more exist above.
+template <typename Map>
+typename Map::const_iterator seekWindow(const Map &side, bool anchored, const typename Map::key_type &key, long scroll,
+                                        size_t page)
+{
+    auto it = anchored ? side.lower_bound(key) : side.begin();
+    if (!anchored && scroll == 0)
+    {
+        return it;
+    }
+
+    for (; scroll > 0 && it != side.end(); --scroll)
+    {
+        ++it;
+    }
+    for (; scroll < 0 && it != side.begin(); ++scroll)
+    {
+        --it;
+    }
+
+    size_t following = 0;
+    for (auto last = it; following < page && last != side.end(); ++following, ++last)
+    {
+    }
+    for (; following < page && it != side.begin(); ++following)
+    {
+        --it;
+    }
+    return it;
+}
+
+// Copies from `it`; returns the rows written
+template <typename Map, typename Row>
+size_t copyFrom(const Map &side, typename Map::const_iterator it, std::vector<OrderBookLevel> &rows, Row row)
+{
+    size_t count = 0;
+    for (; count < rows.size() && it != side.end(); ++count, ++it)
+    {
+        row(*it, rows[count]);
+    }
+    return count;
+}
+
+template <typename Map>
+size_t copySide(const Map &side, double &anchor, long scroll, std::vector<OrderBookLevel> &rows)
+{
+    auto it = seekWindow(side, anchor > 0.0, anchor, scroll, rows.size());
+    anchor = it == side.begin() || it == side.end() ? 0.0 : it->first;
+    return copyFrom(side, it, rows, [](const auto &level, OrderBookLevel &out) {
+        out.setPrice(level.first);
+        out.setQuantity(level.second);
+    });
+}
+
+template <typename BucketMap, typename KeyOf>
+size_t copyBuckets(const BucketMap &buckets, double bucketSize, double &anchor, KeyOf keyOf, long scroll,
+                   std::vector<OrderBookLevel> &rows)
+{
+    auto it = seekWindow(buckets, anchor > 0.0, anchor > 0.0 ? keyOf(anchor) : 0, scroll, rows.size());
+    anchor = it == buckets.begin() || it == buckets.end() ? 0.0 : static_cast<double>(it->first) * bucketSize;
+    return copyFrom(buckets, it, rows, [bucketSize](const auto &bucket, OrderBookLevel &out) {
+        out.setPrice(static_cast<double>(bucket.first) * bucketSize);
+        out.setQuantity(bucket.second.quantity);
+    });
+}
+} // namespace
+
+void OrderBookData::copyAggregatedWindow(size_t ticks, LevelWindow &window) const
+{
+    window.bidCount = window.askCount = window.totalBids = window.totalAsks = 0;
+
+    for (const auto &view : views_)
+    {
+        if (view.ticks != ticks)
+        {
+            continue;
+        }
+
+        auto bidKey = [&view](double price) { return bidBucket(view, price); };
+        auto askKey = [&view](double price) { return askBucket(view, price); };
+        window.bidCount =
+            copyBuckets(view.bids, view.bucketSize, window.bidAnchor, bidKey, window.scroll, window.bids);
+        window.askCount =
+            copyBuckets(view.asks, view.bucketSize, window.askAnchor, askKey, window.scroll, window.asks);
+        window.totalBids = view.bids.size();
+        window.totalAsks = view.asks.size();
+        window.scroll = 0;
+        return;
+    }
+}
+
+void OrderBookData::copyWindow(LevelWindow &window) const
+{
+    window.bidCount = copySide(bids_, window.bidAnchor, window.scroll, window.bids);
+    window.askCount = copySide(asks_, window.askAnchor, window.scroll, window.asks);
+    window.totalBids = bids_.size();
+    window.totalAsks = asks_.size();
+    window.scroll = 0;
+}
+
+TopOfBook OrderBookData::getTopOfBook() const
+{
+    TopOfBook top;
+    if (!bids_.empty())
+    {
+        top.bidPrice = bids_.begin()->first;
+        top.bidQuantity = bids_.begin()->second;
+    }
+    if (!asks_.empty())
+    {
+        top.askPrice = asks_.begin()->first;
+        top.askQuantity = asks_.begin()->second;
+    }
+    return top;
+}
+
 void OrderBookData::clear()
 {
     bids_.clear();
     asks_.clear();
     lastUpdateId_ = 0;
+    resetCoverage();
+    rebuildViews();
+    rebuildIndex();
 }
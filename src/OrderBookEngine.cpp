@@ -0,0 +1,269 @@
+#include "OrderBookEngine.h"
+#include "AsyncLogger.h"
+#include "BookJournal.h"
+#include "MetricsExporter.h"
+#include "WebSocket.h"
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+#include <stdexcept>
+
+namespace
+{
+std::string lowerCase(std::string symbol)
+{
+    std::transform(symbol.begin(), symbol.end(), symbol.begin(), ::tolower);
+    return symbol;
+}
+} // namespace
+
+struct OrderBookEngine::SymbolBook
+{
+    std::string symbol;
+    std::unique_ptr<OrderBookSynchronizer> synchronizer;
+    std::unique_ptr<AveragePrice> avgPrice;
+    std::unique_ptr<BookJournal> journal;
+    std::unique_ptr<DepthHistory> history;
+    size_t analyticsSlot = 0;
+    size_t viewSlot = 0;
+};
+
+struct OrderBookEngine::Impl
+{
+    AnalyticsTable analytics; // Outlives the synchronizers that write to it
+    BookViewTable bookViews;
+    WebSocket feed;
+    std::vector<std::unique_ptr<SymbolBook>> books;
+    mutable std::mutex booksMutex; // For lookups from other threads while symbols change
+    std::mutex controlMutex;       // Serializes symbol changes with start() and stop()
+    MetricsExporter metricsExporter;
+    bool started = false;
+
+    Impl() = default;
+    explicit Impl(size_t feedConnections) : feed(feedConnections)
+    {
+    }
+};
+
+OrderBookEngine::OrderBookEngine() : impl(std::make_unique<Impl>())
+{
+}
+
+OrderBookEngine::OrderBookEngine(size_t feedConnections) : impl(std::make_unique<Impl>(feedConnections))
+{
+}
+
+OrderBookEngine::~OrderBookEngine()
+{
+    stop();
+}
+
+OrderBookEngine::SymbolBook *OrderBookEngine::findBook(const std::string &symbol) const
+{
+    std::string key = lowerCase(symbol);
+    std::lock_guard<std::mutex> lock(impl->booksMutex);
+    for (const auto &book : impl->books)
+    {
+        if (book->symbol == key)
+        {
+            return book.get();
+        }
+    }
+    return nullptr;
+}
+
+OrderBookSynchronizer &OrderBookEngine::addSymbol(const std::string &symbol, const SymbolConfig &config)
+{
+    std::lock_guard<std::mutex> control(impl->controlMutex);
+    if (SymbolBook *existing = findBook(symbol))
+    {
+        return *existing->synchronizer;
+    }
+
+    auto book = std::make_unique<SymbolBook>();
+    book->symbol = lowerCase(symbol);
+    book->synchronizer = std::make_unique<OrderBookSynchronizer>(book->symbol);
+    book->avgPrice = std::make_unique<AveragePrice>();
+
+    OrderBookSynchronizer &synchronizer = *book->synchronizer;
+    synchronizer.setDepthBound(config.depthBound);
+    for (size_t ticks : config.aggregationTicks)
+    {
+        if (ticks > 1)
+        {
+            synchronizer.addAggregationView(ticks);
+        }
+    }
+    if (!config.checkpointPath.empty())
+    {
+        synchronizer.setCheckpointPath(config.checkpointPath);
+    }
+    if (!config.journalDirectory.empty())
+    {
+        book->journal = std::make_unique<BookJournal>(config.journalDirectory);
+        if (book->journal->open())
+        {
+            synchronizer.setJournal(book->journal.get());
+        }
+    }
+
+    if (config.depthIndexTicks > 0)
+    {
+        synchronizer.setDepthIndex(config.depthIndexTicks);
+    }
+
+    if (config.auditIntervalSeconds > 0)
+    {
+        synchronizer.setAuditInterval(std::chrono::seconds(config.auditIntervalSeconds), config.auditRepair);
+    }
+
+    if (config.recordHistory)
+    {
+        book->history = std::make_unique<DepthHistory>(config.history);
+        synchronizer.setDepthHistory(book->history.get());
+    }
+
+    // Cross-symbol row, rewritten by the synchronizer on every BBO change
+    book->analyticsSlot = impl->analytics.addSymbol(book->symbol);
+    book->viewSlot = impl->bookViews.addSymbol(book->symbol);
+    synchronizer.setAnalyticsSlot(&impl->analytics, book->analyticsSlot);
+    synchronizer.setViewSlot(&impl->bookViews, book->viewSlot);
+
+    // Added while running: the pipeline starts before its stream, as in start()
+    if (impl->started)
+    {
+        synchronizer.start();
+    }
+
+    // Depth drives the book; bookTicker drives the mid price without locking the book
+    impl->feed.addDepthStream(book->symbol, synchronizer);
+    impl->feed.addBookTickerStream(book->symbol, *book->avgPrice);
+
+    std::string key = book->symbol;
+    impl->metricsExporter.addSource(key, &synchronizer, [this, key]() { return impl->feed.getFeedStats(key); });
+
+    std::lock_guard<std::mutex> lock(impl->booksMutex);
+    impl->books.push_back(std::move(book));
+    return synchronizer;
+}
+
+bool OrderBookEngine::removeSymbol(const std::string &symbol)
+{
+    std::lock_guard<std::mutex> control(impl->controlMutex);
+    std::string key = lowerCase(symbol);
+
+    std::unique_ptr<SymbolBook> book;
+    {
+        std::lock_guard<std::mutex> lock(impl->booksMutex);
+        auto it = std::find_if(impl->books.begin(), impl->books.end(),
+                               [&key](const auto &entry) { return entry->symbol == key; });
+        if (it == impl->books.end())
+        {
+            return false;
+        }
+        book = std::move(*it);
+        impl->books.erase(it);
+    }
+
+    // Consumers of the book go first: once the feed returns no handler can reach the synchronizer,
+    // and once the exporter returns no scrape reads it
+    impl->feed.removeSymbol(key);
+    impl->metricsExporter.removeSource(key);
+    book->synchronizer->stop();
+
+    // An empty row reads as NaN, so the symbol drops out of the cross-symbol kernels
+    impl->analytics.update(book->analyticsSlot, TopOfBook{}, 0);
+    impl->bookViews.publish(book->viewSlot, OrderBookData(), 0, 0);
+    return true;
+}
+
+void OrderBookEngine::start()
+{
+    std::lock_guard<std::mutex> control(impl->controlMutex);
+    if (impl->started)
+    {
+        return;
+    }
+    impl->started = true;
+
+    // Hot threads log into rings; the writer thread owns the file
+    AsyncLogger::instance().start();
+
+    for (const auto &book : impl->books)
+    {
+        book->synchronizer->start();
+    }
+    impl->feed.start();
+}
+
+void OrderBookEngine::stop()
+{
+    std::lock_guard<std::mutex> control(impl->controlMutex);
+    if (!impl->started)
+    {
+        return;
+    }
+    impl->started = false;
+
+    // Stop the sources before the consumers
+    impl->metricsExporter.stop();
+    impl->feed.stop();
+    for (const auto &book : impl->books)
+    {
+        book->synchronizer->stop();
+    }
+}
+
+bool OrderBookEngine::startMetrics(unsigned short port)
+{
+    return impl->metricsExporter.start(port);
+}
+
+OrderBookSynchronizer *OrderBookEngine::getSynchronizer(const std::string &symbol) const
+{
+    SymbolBook *book = findBook(symbol);
+    return book ? book->synchronizer.get() : nullptr;
+}
+
+AveragePrice *OrderBookEngine::getAveragePrice(const std::string &symbol) const
+{
+    SymbolBook *book = findBook(symbol);
+    return book ? book->avgPrice.get() : nullptr;
+}
+
+const DepthHistory *OrderBookEngine::getDepthHistory(const std::string &symbol) const
+{
+    SymbolBook *book = findBook(symbol);
+    return book ? book->history.get() : nullptr;
+}
+
+std::vector<FeedConnectionStats> OrderBookEngine::getFeedStats(const std::string &symbol) const
+{
+    return impl->feed.getFeedStats(lowerCase(symbol));
+}
+
+const AnalyticsTable &OrderBookEngine::getAnalytics() const
+{
+    return impl->analytics;
+}
+
+const BookViewTable &OrderBookEngine::getBookViews() const
+{
+    return impl->bookViews;
+}
+
+bool OrderBookEngine::readBooks(const std::vector<std::string> &symbols, MultiBookView &out) const
+{
+    std::vector<size_t> slots;
+    slots.reserve(symbols.size());
+    for (const auto &symbol : symbols)
+    {
+        size_t slot = impl->bookViews.findSymbol(lowerCase(symbol));
+        if (slot == BookViewTable::NOT_FOUND)
+        {
+            throw std::invalid_argument("readBooks: symbol was never added: " + symbol);
+        }
+        slots.push_back(slot);
+    }
+    return impl->bookViews.read(slots, out);
+}
@@ -20,7 +20,7 @@ void OrderBookManager::setSynchronizer(OrderBookSynchronizer *sync)
 
 void OrderBookManager::updateOrderBook(const BidsMap &bids, const AsksMap &asks, long long updateId)
 {
-    std::lock_guard<std::mutex> lock(orderbook_mutex);
+    ProfiledLock lock(orderbook_mutex);
 
     for (const auto &bid : bids)
     {
@@ -134,7 +134,7 @@ OrderBookData OrderBookManager::getOrderBookSnapshot() const
     {
         return synchronizer->getOrderBookSnapshot();
     }
-    std::lock_guard<std::mutex> lock(orderbook_mutex);
+    ProfiledLock lock(orderbook_mutex);
     return orderbook;
 }
 
@@ -144,10 +144,32 @@ std::pair<std::vector<OrderBookLevel>, std::vector<OrderBookLevel>> OrderBookMan
     {
         return synchronizer->getTopLevels(levels);
     }
-    std::lock_guard<std::mutex> lock(orderbook_mutex);
+    ProfiledLock lock(orderbook_mutex);
     return std::make_pair(orderbook.getTopBids(levels), orderbook.getTopAsks(levels));
 }
 
+void OrderBookManager::copyLevelWindow(LevelWindow &window) const
+{
+    if (synchronizer)
+    {
+        synchronizer->copyLevelWindow(window);
+        return;
+    }
+    ProfiledLock lock(orderbook_mutex);
+    orderbook.copyWindow(window);
+}
+
+void OrderBookManager::copyAggregatedWindow(size_t ticks, LevelWindow &window) const
+{
+    if (synchronizer)
+    {
+        synchronizer->copyAggregatedWindow(ticks, window);
+        return;
+    }
+    ProfiledLock lock(orderbook_mutex);
+    orderbook.copyAggregatedWindow(ticks, window);
+}
+
 void OrderBookManager::setUpdateCallback(const std::function<void()> &callback)
 {
     updateCallback = callback;
@@ -168,9 +190,14 @@ bool OrderBookManager::isInitialized() const
     return initialized.load();
 }
 
+bool OrderBookManager::isStale() const
+{
+    return synchronizer && synchronizer->isStale();
+}
+
 void OrderBookManager::reset()
 {
-    std::lock_guard<std::mutex> lock(orderbook_mutex);
+    ProfiledLock lock(orderbook_mutex);
     orderbook.clear();
     initialized.store(false);
 }
@@ -1,7 +1,101 @@
 #include "OrderBookSynchronizer.h"
+#include "AllocationTracker.h"
+#include "AsyncLogger.h"
 #include <algorithm>
-#include <iostream>
-#include <json/json.h>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+namespace
+{
+// Price of the Nth best level, or NaN when the side is shorter than that
+template <typename Levels> double nthPrice(const Levels &levels, size_t n)
+{
+    if (levels.size() < n)
+    {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return std::next(levels.begin(), n - 1)->first;
+}
+
+// co_await on a RestRequest sends a REST call without holding a thread. A cancelled request
+// resumes at once with an empty result and ignores the late response.
+template <typename Result> struct RestRequest
+{
+    std::function<void(std::function<void(Result &&)>)> send;
+    std::shared_ptr<PendingFetch<Result>> fetch;
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        // Once the waiter is published a cancel may resume the coroutine and free this awaiter
+        auto sendRequest = send;
+        std::shared_ptr<PendingFetch<Result>> state = fetch;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->cancelled)
+            {
+                return false;
+            }
+            state->waiter = handle;
+        }
+
+        sendRequest([state](Result &&result) {
+            std::coroutine_handle<> waiter;
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->waiter)
+                {
+                    return; // Cancelled
+                }
+                state->result = std::move(result);
+                waiter = std::exchange(state->waiter, nullptr);
+            }
+            SyncExecutor::instance().post(waiter);
+        });
+        return true;
+    }
+
+    Result await_resume()
+    {
+        std::lock_guard<std::mutex> lock(fetch->mutex);
+        return std::move(fetch->result);
+    }
+};
+
+RestRequest<DepthSnapshot> snapshotRequest(const std::string &symbol, int limit,
+                                           std::shared_ptr<PendingFetch<DepthSnapshot>> fetch)
+{
+    return {[symbol, limit](BinanceAPI::SnapshotCompletion done) {
+                BinanceAPI::fetchDepthSnapshot(symbol, limit, std::move(done));
+            },
+            std::move(fetch)};
+}
+
+RestRequest<double> tickSizeRequest(const std::string &symbol, std::shared_ptr<PendingFetch<double>> fetch)
+{
+    return {[symbol](BinanceAPI::TickSizeCompletion done) { BinanceAPI::fetchTickSize(symbol, std::move(done)); },
+            std::move(fetch)};
+}
+} // namespace
+
+void RestFetch::cancel()
+{
+    std::coroutine_handle<> resumed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelled = true;
+        resumed = std::exchange(waiter, nullptr);
+    }
+    if (resumed)
+    {
+        SyncExecutor::instance().post(resumed);
+    }
+}
 
 OrderBookSynchronizer::OrderBookSynchronizer(const std::string &tradingSymbol) : symbol(tradingSymbol)
 {
@@ -21,12 +115,33 @@ void OrderBookSynchronizer::start()
 
     running.store(true);
     state.store(SyncState::INITIALIZING);
+    metrics.resyncStartNs.set(metricsNowNs());
+
+    // Show the last persisted book right away while the live sync catches up
+    loadWarmCheckpoint();
 
-    // Start background processing thread
-    processingThread = std::thread(&OrderBookSynchronizer::backgroundProcessor, this);
+    pipelineDone = std::promise<void>();
+    pipelineFinished = pipelineDone.get_future();
+    runPipeline();
+}
+
+void OrderBookSynchronizer::startOffline(const DepthSnapshot &snapshot)
+{
+    if (running.load())
+    {
+        return;
+    }
 
-    // Request initial snapshot
-    requestSnapshot();
+    running.store(true);
+    metrics.resyncStartNs.set(metricsNowNs());
+
+    // No pipeline to wait for in stop()
+    pipelineDone = std::promise<void>();
+    pipelineFinished = pipelineDone.get_future();
+    pipelineDone.set_value();
+
+    handleSnapshotReceived(snapshot, false);
+    processEventBuffer();
 }
 
 void OrderBookSynchronizer::stop()
@@ -36,42 +151,93 @@ void OrderBookSynchronizer::stop()
 
     running.store(false);
 
-    if (processingThread.joinable())
+    // The pipeline exits at its next resumption. An in-flight snapshot may be held back by a
+    // rate-limit backoff for up to a minute, so it is cancelled rather than waited for.
+    {
+        std::lock_guard<std::mutex> lock(fetchMutex);
+        if (activeFetch)
+        {
+            activeFetch->cancel();
+        }
+    }
+    wakeSignal.notify();
+    pipelineFinished.wait();
+
+    // Persist the freshest book so the next start is warm
+    if (isSynchronized() && !backfillPending.load() && !checkpointPath.empty())
+    {
+        BookCheckpoint::save(checkpointPath, getOrderBookSnapshot());
+    }
+}
+
+template <typename Result> std::shared_ptr<PendingFetch<Result>> OrderBookSynchronizer::beginFetch()
+{
+    auto fetch = std::make_shared<PendingFetch<Result>>();
+    std::lock_guard<std::mutex> lock(fetchMutex);
+    activeFetch = fetch;
+
+    // stop() may have run before this fetch was registered
+    if (!running.load())
     {
-        processingThread.join();
+        fetch->cancel();
     }
+    return fetch;
 }
 
 void OrderBookSynchronizer::reset()
 {
-    std::lock_guard<std::mutex> orderLock(orderBookMutex);
-    std::lock_guard<std::mutex> bufferLock(bufferMutex);
+    ProfiledLock orderLock(orderBookMutex);
+    ProfiledLock bufferLock(bufferMutex);
 
     // Reset all state
     state.store(SyncState::INITIALIZING);
+    metrics.resyncs.add();
+    metrics.resyncStartNs.set(metricsNowNs());
     orderBook.clear();
     localUpdateId.store(0);
     firstBufferedEventU.store(0);
     clearBuffer();
-    snapshotRequested.store(false);
+    stale.store(false);
+    backfillPending.store(false);
+    bidTouches.clear();
+    askTouches.clear();
+    syncGeneration.fetch_add(1);
+    publishBookReplaced(metricsNowNs());
+
+    // The pipeline requests a new snapshot once events are buffering again
+    wakeSignal.notify();
+}
+
+void OrderBookSynchronizer::processDepthEvent(std::string_view jsonData)
+{
+    if (!running.load())
+        return;
 
-    // Request new snapshot
-    requestSnapshot();
+    // Reused per thread so parsing keeps its level buffers
+    thread_local DepthEvent event;
+    {
+        ORDERBOOK_ALLOC_STAGE(PARSE);
+        parseDepthEvent(jsonData, event);
+    }
+    processDepthEvent(event);
 }
 
-void OrderBookSynchronizer::processDepthEvent(const std::string &jsonData)
+void OrderBookSynchronizer::processDepthEvent(const DepthEvent &event)
 {
     if (!running.load())
         return;
 
+    ORDERBOOK_ALLOC_STAGE(SEQUENCE);
+
     try
     {
-        DepthEvent event = parseDepthEvent(jsonData);
         if (event.finalUpdateId == 0)
         {
             return; // Invalid event
         }
 
+        metrics.latestReceivedUpdateId.setMax(event.finalUpdateId);
+
         auto currentState = state.load();
 
         switch (currentState)
@@ -81,13 +247,12 @@ void OrderBookSynchronizer::processDepthEvent(const std::string &jsonData)
             // Buffer events and note the U of the first event (Step 2)
             bufferEvent(event);
 
-            // If this is the first event, note its U
-            if (firstBufferedEventU.load() == 0)
+            // Let the pipeline fetch the snapshot (Step 3)
+            if (currentState == SyncState::INITIALIZING)
             {
-                firstBufferedEventU.store(event.firstUpdateId);
+                state.store(SyncState::BUFFERING);
+                wakeSignal.notify();
             }
-
-            state.store(SyncState::BUFFERING);
             break;
 
         case SyncState::SNAPSHOT_RECEIVED:
@@ -97,158 +262,488 @@ void OrderBookSynchronizer::processDepthEvent(const std::string &jsonData)
 
         case SyncState::SYNCHRONIZED:
             // Real-time processing
+            if (event.finalUpdateId <= localUpdateId.load())
+            {
+                break; // Already applied, e.g. a late copy from a reconnected feed
+            }
+
             if (validateEventSequence(event))
             {
                 applyDepthEvent(event);
+
+                if (refillNeeded.exchange(false))
+                {
+                    reset();
+                }
             }
             else
             {
-                std::cout << "Event sequence validation failed. Resetting..." << std::endl;
+                LOG_WARN("{}: event sequence validation failed, resetting", symbol);
                 reset();
             }
             break;
 
         case SyncState::ERROR_STATE:
-            std::cout << "Ignoring event - in error state" << std::endl;
+            LOG_DEBUG("{}: ignoring event u={} in error state", symbol, event.finalUpdateId);
             break;
         }
     }
     catch (const std::exception &e)
     {
-        std::cerr << "Error processing depth event: " << e.what() << std::endl;
+        LOG_ERROR("{}: error processing depth event: {}", symbol, e.what());
         state.store(SyncState::ERROR_STATE);
+        wakeSignal.notify();
     }
 }
 
-void OrderBookSynchronizer::backgroundProcessor()
+DetachedTask OrderBookSynchronizer::runPipeline()
 {
+    SyncExecutor &executor = SyncExecutor::instance();
+    co_await executor.schedule();
+
+    // The exchange's PRICE_FILTER is exact, unlike a tick inferred from the gaps in a snapshot
+    auto tickRequest = tickSizeRequest(symbol, beginFetch<double>());
+    double tickSize = co_await tickRequest;
+    if (tickSize > 0.0)
+    {
+        ProfiledLock lock(orderBookMutex);
+        orderBook.setTickSize(tickSize);
+    }
 
     while (running.load())
     {
         try
         {
-            auto currentState = state.load();
-
-            switch (currentState)
+            switch (state.load())
             {
+            case SyncState::INITIALIZING:
+                // Nothing to do until the stream delivers its first event
+                co_await wakeSignal.waitFor(std::chrono::seconds(IDLE_WAIT_S));
+                break;
+
             case SyncState::BUFFERING:
-                // Check if snapshot is ready
-                if (snapshotFuture.valid() &&
-                    snapshotFuture.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready)
+            {
+                // Sync on a cheap shallow snapshot first; the deep levels follow once synchronized
+                int limit = getSnapshotLimit();
+                bool shallow = limit > SHALLOW_SNAPSHOT_LIMIT;
+                auto request =
+                    snapshotRequest(symbol, shallow ? SHALLOW_SNAPSHOT_LIMIT : limit, beginFetch<DepthSnapshot>());
+                DepthSnapshot snapshot = co_await request;
+                if (!running.load() || state.load() != SyncState::BUFFERING)
                 {
+                    break;
+                }
 
-                    DepthSnapshot snapshot = snapshotFuture.get();
-                    handleSnapshotReceived(snapshot);
+                // Failed and stale snapshots alike wait before the next request, so a slow REST
+                // endpoint cannot burn through the weight budget
+                if (!snapshot.isValid || !handleSnapshotReceived(snapshot, shallow))
+                {
+                    co_await wakeSignal.waitFor(std::chrono::milliseconds(SNAPSHOT_RETRY_DELAY_MS));
                 }
                 break;
+            }
 
             case SyncState::SNAPSHOT_RECEIVED:
                 processEventBuffer();
                 break;
 
-            case SyncState::ERROR_STATE:
-                std::cout << "In error state, attempting reset..." << std::endl;
-                std::this_thread::sleep_for(std::chrono::seconds(5));
-                reset();
-                break;
+            case SyncState::SYNCHRONIZED:
+            {
+                if (backfillPending.load())
+                {
+                    uint64_t generation = syncGeneration.load();
+                    auto request = snapshotRequest(symbol, getSnapshotLimit(), beginFetch<DepthSnapshot>());
+                    DepthSnapshot deep = co_await request;
+
+                    // A reset while the request was in flight makes this snapshot useless
+                    if (!running.load() || generation != syncGeneration.load())
+                    {
+                        break;
+                    }
+                    if (!deep.isValid || !mergeBackfill(deep))
+                    {
+                        co_await wakeSignal.waitFor(std::chrono::milliseconds(SNAPSHOT_RETRY_DELAY_MS));
+                    }
+                    break;
+                }
+
+                if (isAuditDue())
+                {
+                    uint64_t generation = syncGeneration.load();
+                    long long startId = 0;
+                    beginAudit(startId);
+                    auto request = snapshotRequest(symbol, getSnapshotLimit(), beginFetch<DepthSnapshot>());
+                    DepthSnapshot reference = co_await request;
+
+                    // The stream can trail the REST snapshot; give the book a moment to catch up
+                    for (int attempt = 0; attempt < AUDIT_CATCH_UP_ATTEMPTS && running.load() &&
+                                          localUpdateId.load() < reference.lastUpdateId;
+                         ++attempt)
+                    {
+                        co_await wakeSignal.waitFor(std::chrono::milliseconds(AUDIT_CATCH_UP_MS));
+                    }
+
+                    // A reset in the meantime replaced the book being audited
+                    if (running.load() && generation == syncGeneration.load() && reference.isValid)
+                    {
+                        finishAudit(reference, startId);
+                    }
+                    endAudit();
+                    break;
+                }
 
-            default:
+                // Live events are applied on the feed thread; wake for resets or the next checkpoint
+                auto deadline = SyncExecutor::Clock::now() + std::chrono::seconds(CHECKPOINT_SAVE_INTERVAL_S);
+                bool woken = co_await wakeSignal.waitFor(std::chrono::seconds(CHECKPOINT_SAVE_INTERVAL_S));
+
+                if (!woken)
+                {
+                    // Late timer resumption shows how starved the executor is
+                    metrics.loopLagNs.set(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(SyncExecutor::Clock::now() - deadline)
+                            .count());
+                }
+
+                if (state.load() == SyncState::SYNCHRONIZED && !backfillPending.load())
+                {
+                    saveCheckpointIfDue();
+                }
                 break;
             }
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            case SyncState::ERROR_STATE:
+                LOG_WARN("{}: in error state, attempting reset", symbol);
+                co_await wakeSignal.waitFor(std::chrono::seconds(ERROR_RETRY_DELAY_S));
+                if (running.load())
+                {
+                    reset();
+                }
+                break;
+            }
         }
         catch (const std::exception &e)
         {
-            std::cerr << "Error in background processor: " << e.what() << std::endl;
+            LOG_ERROR("{}: error in sync pipeline: {}", symbol, e.what());
             state.store(SyncState::ERROR_STATE);
         }
     }
+
+    pipelineDone.set_value();
 }
 
-void OrderBookSynchronizer::requestSnapshot()
+int OrderBookSynchronizer::getSnapshotLimit() const
 {
-    if (snapshotRequested.load())
-    {
-        return;
-    }
-
-    snapshotRequested.store(true);
-    snapshotFuture = BinanceAPI::getDepthSnapshotAsync(symbol, 5000);
+    ProfiledLock lock(orderBookMutex);
+    return getSnapshotLimitLocked();
 }
 
-void OrderBookSynchronizer::handleSnapshotReceived(const DepthSnapshot &snapshot)
+int OrderBookSynchronizer::getSnapshotLimitLocked() const
 {
-    if (!snapshot.isValid)
+    // A level-bounded book only needs as many levels as it keeps
+    const DepthBound &bound = orderBook.getDepthBound();
+    if (bound.maxLevels > 0 && bound.maxDistancePct == 0.0)
     {
-        snapshotRequested.store(false);
-        std::this_thread::sleep_for(std::chrono::milliseconds(SNAPSHOT_RETRY_DELAY_MS));
-        requestSnapshot();
-        return;
+        return static_cast<int>(std::min<size_t>(orderBook.getLevelCapacity(), MAX_SNAPSHOT_LIMIT));
     }
+    return MAX_SNAPSHOT_LIMIT;
+}
 
-    // Step 4: If lastUpdateId < U from first buffered event, retry snapshot
+bool OrderBookSynchronizer::handleSnapshotReceived(const DepthSnapshot &snapshot, bool shallow)
+{
+    // Step 4: If lastUpdateId < U from first buffered event, stay buffering and fetch again
     long long firstU = firstBufferedEventU.load();
     if (firstU > 0 && snapshot.lastUpdateId < firstU)
     {
-
-        snapshotRequested.store(false);
-        requestSnapshot();
-        return;
+        LOG_DEBUG("{}: snapshot {} predates buffered U={}, refetching", symbol, snapshot.lastUpdateId, firstU);
+        return false;
     }
 
     // Step 6: Set local order book to snapshot
     {
-        std::lock_guard<std::mutex> lock(orderBookMutex);
-        orderBook.getBids() = snapshot.bids;
-        orderBook.getAsks() = snapshot.asks;
-        orderBook.setLastUpdateId(snapshot.lastUpdateId);
+        ProfiledLock lock(orderBookMutex);
+        orderBook.replaceLevels(snapshot.bids, snapshot.asks, snapshot.lastUpdateId);
         localUpdateId.store(snapshot.lastUpdateId);
+
+        // Sides shorter than the limit are already complete
+        bool partial = shallow && (snapshot.bids.size() >= static_cast<size_t>(SHALLOW_SNAPSHOT_LIMIT) ||
+                                   snapshot.asks.size() >= static_cast<size_t>(SHALLOW_SNAPSHOT_LIMIT));
+        if (partial)
+        {
+            shallowSnapshotId = snapshot.lastUpdateId;
+            bidHorizon = snapshot.bids.empty() ? 0.0 : snapshot.bids.rbegin()->first;
+            askHorizon = snapshot.asks.empty() ? 0.0 : snapshot.asks.rbegin()->first;
+            bidTouches.clear();
+            askTouches.clear();
+        }
+        backfillPending.store(partial);
+        publishBookReplaced(metricsNowNs());
+
+        // Deltas after a resync only make sense on top of the new snapshot
+        if (journal)
+        {
+            journal->appendCheckpoint(BookJournal::now(), orderBook);
+        }
     }
 
     state.store(SyncState::SNAPSHOT_RECEIVED);
+    return true;
 }
 
-void OrderBookSynchronizer::processEventBuffer()
+bool OrderBookSynchronizer::mergeBackfill(const DepthSnapshot &deep)
 {
-    std::lock_guard<std::mutex> lock(bufferMutex);
-
-    long long currentUpdateId = localUpdateId.load();
-
-    size_t processed = 0;
-    size_t discarded = 0;
-
-    // Step 5: Discard events where u <= lastUpdateId of snapshot
-    while (!eventBuffer.empty())
     {
-        DepthEvent event = eventBuffer.front();
-        eventBuffer.pop();
+        ProfiledLock lock(orderBookMutex);
 
-        // Discard old events
-        if (event.finalUpdateId <= currentUpdateId)
+        if (!backfillPending.load())
         {
-            discarded++;
-            continue;
+            return true;
         }
 
-        // Step 5 continued: First buffered event should have lastUpdateId within [U;u] range
-        if (processed == 0)
+        // Changes between an older deep snapshot and the shallow one were never tracked
+        if (deep.lastUpdateId < shallowSnapshotId)
         {
-            if (!(event.firstUpdateId <= currentUpdateId + 1 && event.finalUpdateId >= currentUpdateId + 1))
+            return false;
+        }
+
+        // Beyond the horizon the deep snapshot wins unless a live event changed the price after it.
+        // A deep snapshot ahead of the live book is fine too: the events in between still arrive.
+        long long deepId = deep.lastUpdateId;
+        auto isNewer = [deepId](const std::map<double, long long> &touches, double price) {
+            auto touch = touches.find(price);
+            return touch != touches.end() && touch->second > deepId;
+        };
+
+        int64_t journalTime = journal ? BookJournal::now() : 0;
+        auto setLevel = [&](JournalSide side, double price, double quantity) {
+            bool applied = side == JournalSide::BID ? orderBook.setBid(price, quantity)
+                                                    : orderBook.setAsk(price, quantity);
+
+            // No depth event carries these changes, so they are journaled at the current id
+            if (applied && journal)
             {
-                state.store(SyncState::ERROR_STATE);
-                return;
+                journal->appendDelta(journalTime, localUpdateId.load(), side, price, quantity);
             }
+        };
+
+        // Deep levels inserted by live events that the snapshot says are gone
+        std::vector<std::pair<JournalSide, double>> removals;
+        for (auto it = orderBook.getBids().upper_bound(bidHorizon); it != orderBook.getBids().end(); ++it)
+        {
+            if (!deep.bids.count(it->first) && !isNewer(bidTouches, it->first))
+                removals.emplace_back(JournalSide::BID, it->first);
+        }
+        for (auto it = orderBook.getAsks().upper_bound(askHorizon); it != orderBook.getAsks().end(); ++it)
+        {
+            if (!deep.asks.count(it->first) && !isNewer(askTouches, it->first))
+                removals.emplace_back(JournalSide::ASK, it->first);
         }
+        for (const auto &[side, price] : removals)
+        {
+            setLevel(side, price, 0.0);
+        }
+
+        for (auto it = deep.bids.upper_bound(bidHorizon); it != deep.bids.end(); ++it)
+        {
+            if (!isNewer(bidTouches, it->first))
+                setLevel(JournalSide::BID, it->first, it->second);
+        }
+        for (auto it = deep.asks.upper_bound(askHorizon); it != deep.asks.end(); ++it)
+        {
+            if (!isNewer(askTouches, it->first))
+                setLevel(JournalSide::ASK, it->first, it->second);
+        }
+
+        enforceDepthBound(journalTime, localUpdateId.load());
+        backfillPending.store(false);
+        bidTouches.clear();
+        askTouches.clear();
+        publishBookReplaced(metricsNowNs());
+    }
+
+    if (updateCallback)
+    {
+        updateCallback();
+    }
+    return true;
+}
 
-        // Apply the event
-        applyDepthEvent(event);
-        processed++;
+void OrderBookSynchronizer::loadWarmCheckpoint()
+{
+    if (checkpointPath.empty())
+    {
+        return;
+    }
+
+    OrderBookData warmBook;
+    if (!BookCheckpoint::load(checkpointPath, warmBook, MAX_CHECKPOINT_AGE_S))
+    {
+        return;
     }
 
+    {
+        ProfiledLock lock(orderBookMutex);
+        orderBook.replaceLevels(warmBook.getBids(), warmBook.getAsks(), warmBook.getLastUpdateId());
+        localUpdateId.store(orderBook.getLastUpdateId());
+        publishBookReplaced(metricsNowNs());
+    }
+
+    stale.store(true);
+
+    if (updateCallback)
+    {
+        updateCallback();
+    }
+}
+
+bool OrderBookSynchronizer::isAuditDue() const
+{
+    return auditInterval.count() > 0 && !backfillPending.load() && std::chrono::steady_clock::now() >= nextAudit;
+}
+
+void OrderBookSynchronizer::beginAudit(long long &startId)
+{
+    nextAudit = std::chrono::steady_clock::now() + auditInterval;
+
+    // Not capturing yet, so the applying thread leaves the buffer alone and it can grow off the lock
+    std::vector<AuditDelta> deltas;
+    deltas.reserve(AUDIT_CAPACITY);
+
+    // Every event applied after this point is recorded, so the updates with u > startId are complete
+    ProfiledLock lock(orderBookMutex);
+    auditDeltas.swap(deltas);
+    auditBroken = false;
+    auditCapturing = true;
+    startId = localUpdateId.load();
+}
+
+void OrderBookSynchronizer::recordAuditDelta(long long updateId, BookSide side, double price, double quantity)
+{
+    if (auditDeltas.size() < AUDIT_CAPACITY)
+    {
+        auditDeltas.push_back({updateId, price, quantity, side});
+    }
+    else
+    {
+        auditBroken = true;
+    }
+}
+
+void OrderBookSynchronizer::endAudit()
+{
+    // The buffer is only needed while a snapshot is in flight; freed after the lock is released
+    std::vector<AuditDelta> deltas;
+    ProfiledLock lock(orderBookMutex);
+    auditCapturing = false;
+    auditDeltas.swap(deltas);
+}
+
+void OrderBookSynchronizer::finishAudit(DepthSnapshot &reference, long long startId)
+{
+    metrics.audits.add();
+
+    // The snapshot must come from after the subscription started so the changes can bridge it
+    long long referenceId = reference.lastUpdateId;
+    if (referenceId < startId)
+    {
+        LOG_DEBUG("{}: audit skipped, snapshot {} predates the audit start {}", symbol, referenceId, startId);
+        return;
+    }
+
+    // The only time under the book lock: copying the top levels into preallocated rows
+    size_t rows = std::max(reference.bids.size(), reference.asks.size()) + AUDIT_WINDOW_SLACK;
+    if (auditWindow.bids.size() < rows)
+    {
+        auditWindow.bids.resize(rows, OrderBookLevel(0.0, 0.0));
+        auditWindow.asks.resize(rows, OrderBookLevel(0.0, 0.0));
+    }
+    long long liveId = 0;
+    bool bounded = false;
+    bool broken = false;
+    {
+        // Recording stops with the copy, so the updates can be read off the lock
+        ProfiledLock lock(orderBookMutex);
+        orderBook.copyWindow(auditWindow);
+        liveId = localUpdateId.load();
+        bounded = orderBook.getDepthBound().isBounded();
+        auditCapturing = false;
+        broken = auditBroken;
+    }
+
+    if (broken || liveId < referenceId)
+    {
+        LOG_DEBUG("{}: audit skipped, could not roll snapshot {} to book u={}", symbol, referenceId, liveId);
+        return;
+    }
+    BookAudit::rollForward(reference, auditDeltas, liveId);
+
+    BookAuditResult result = audit.compare(reference, auditWindow, bounded);
+    if (!result.diverged())
+    {
+        LOG_DEBUG("{}: audit at u={} matched {} levels", symbol, result.updateId, result.comparedLevels);
+        return;
+    }
+
+    metrics.auditDivergences.add();
+    LOG_WARN("{}: book drifted from snapshot at u={}: {} of {} levels differ, first {} at {}", symbol,
+             result.updateId, result.mismatchedLevels, result.comparedLevels,
+             result.firstMismatchSide == BookSide::BID ? "bid" : "ask", result.firstMismatchPrice);
+    if (auditRepair)
+    {
+        reset();
+    }
+}
+
+void OrderBookSynchronizer::saveCheckpointIfDue()
+{
+    if (checkpointPath.empty())
+    {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastCheckpointSave < std::chrono::seconds(CHECKPOINT_SAVE_INTERVAL_S))
+    {
+        return;
+    }
+    lastCheckpointSave = now;
+
+    // Copy under the lock, write outside it
+    BookCheckpoint::save(checkpointPath, getOrderBookSnapshot());
+}
+
+void OrderBookSynchronizer::processEventBuffer()
+{
+    ProfiledLock lock(bufferMutex);
+
+    long long currentUpdateId = localUpdateId.load();
+
+    // Step 5: Drop what the snapshot already has and apply from the event straddling its
+    // lastUpdateId. The buffer holds the net result per price, so this is one combined event.
+    if (eventBuffer.getFinalUpdateId() > currentUpdateId)
+    {
+        if (!eventBuffer.reaches(currentUpdateId))
+        {
+            LOG_WARN("{}: buffered events start at U={}, after snapshot {}", symbol, eventBuffer.getFirstUpdateId(),
+                     currentUpdateId);
+            state.store(SyncState::ERROR_STATE);
+            return;
+        }
+
+        LOG_DEBUG("{}: replaying {} buffered events as {} levels", symbol, eventBuffer.getEventCount(),
+                  eventBuffer.getLevelCount());
+        eventBuffer.extractAfter(currentUpdateId, replayEvent);
+        applyDepthEvent(replayEvent);
+    }
+    clearBuffer();
+
     // Step 7: Now synchronized - apply subsequent events in real-time
     state.store(SyncState::SYNCHRONIZED);
 
+    int64_t resyncDuration = metricsNowNs() - metrics.resyncStartNs.load();
+    metrics.lastResyncDurationNs.set(resyncDuration);
+    metrics.resyncDurationTotalNs.add(static_cast<uint64_t>(resyncDuration));
+    stale.store(false);
+
     if (updateCallback)
     {
         updateCallback();
@@ -268,159 +763,350 @@ bool OrderBookSynchronizer::validateEventSequence(const DepthEvent &event) const
     // Step 2 of update procedure: If U > local update ID + 1, something went wrong
     if (event.firstUpdateId > currentUpdateId + 1)
     {
-        std::cout << "Gap detected! Expected U <= " << (currentUpdateId + 1) << ", got U = " << event.firstUpdateId
-                  << std::endl;
+        metrics.gaps.add();
+        LOG_WARN("{}: gap detected, expected U <= {}, got U = {}", symbol, currentUpdateId + 1, event.firstUpdateId);
         return false; // This triggers reset
     }
 
     return true;
 }
 
-void OrderBookSynchronizer::applyDepthEvent(const DepthEvent &event)
+void OrderBookSynchronizer::enforceDepthBound(int64_t journalTime, long long updateId)
 {
-    std::lock_guard<std::mutex> lock(orderBookMutex);
+    if (!journal)
+    {
+        orderBook.enforceDepthBound();
+        return;
+    }
 
-    // Step 3 of update procedure: Apply price level changes
-    for (const auto &[price, quantity] : event.bids)
+    // Pruned levels leave the journaled book too, as removals at the id that pushed them out
+    prunedLevels.clear();
+    orderBook.enforceDepthBound(&prunedLevels);
+    for (const PrunedLevel &level : prunedLevels)
     {
-        if (quantity == 0.0)
+        JournalSide side = level.isBid ? JournalSide::BID : JournalSide::ASK;
+        journal->appendDelta(journalTime, updateId, side, level.price, 0.0);
+    }
+}
+
+void OrderBookSynchronizer::applyDepthEvent(const DepthEvent &event)
+{
+    {
+        ORDERBOOK_ALLOC_STAGE(APPLY);
+        ProfiledLock lock(orderBookMutex);
+
+        int64_t journalTime = journal ? BookJournal::now() : 0;
+
+        // Level changes are only collected while someone is subscribed
+        LevelChangeHub::Subscribers subscribers = changeHub.getSubscribers();
+        TopOfBook topBefore;
+        if (subscribers || analyticsTable)
         {
-            orderBook.getBids().erase(price);
+            topBefore = orderBook.getTopOfBook();
         }
-        else
+
+        int64_t receiveTimeNs =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(event.timestamp.time_since_epoch()).count();
+        if (subscribers)
         {
-            orderBook.getBids()[price] = quantity;
+            pendingChanges.clear();
+            captureHorizons(subscribers->depths, true);
         }
-    }
 
-    for (const auto &[price, quantity] : event.asks)
-    {
-        if (quantity == 0.0)
+        // The first event of each interval records the book as it stood at the boundary
+        if (depthHistory)
         {
-            orderBook.getAsks().erase(price);
+            depthHistory->sample(orderBook, receiveTimeNs);
         }
-        else
+
+        // Remember live changes beyond the shallow horizon until the deep snapshot is merged
+        if (backfillPending.load())
         {
-            orderBook.getAsks()[price] = quantity;
+            for (const auto &level : event.bids)
+            {
+                if (level.first < bidHorizon)
+                    bidTouches[level.first] = event.finalUpdateId;
+            }
+            for (const auto &level : event.asks)
+            {
+                if (level.first > askHorizon)
+                    askTouches[level.first] = event.finalUpdateId;
+            }
         }
-    }
 
-    // Step 4 of update procedure: Set order book update ID to u
-    orderBook.setLastUpdateId(event.finalUpdateId);
-    localUpdateId.store(event.finalUpdateId);
+        // Step 3 of update procedure: Apply price level changes
+        for (const auto &[price, quantity] : event.bids)
+        {
+            double previous = 0.0;
+            if (subscribers)
+            {
+                auto level = orderBook.getBids().find(price);
+                previous = level != orderBook.getBids().end() ? level->second : 0.0;
+            }
+
+            if (auditCapturing)
+            {
+                recordAuditDelta(event.finalUpdateId, BookSide::BID, price, quantity);
+            }
 
-    // Trigger UI update
+            // Levels beyond the depth bound are ignored, so neither published nor journaled
+            if (!orderBook.setBid(price, quantity))
+            {
+                continue;
+            }
+
+            if (subscribers && previous != quantity)
+            {
+                pendingChanges.push_back(
+                    {event.finalUpdateId, receiveTimeNs, price, previous, quantity, BookSide::BID, 0});
+            }
+
+            if (journal)
+            {
+                journal->appendDelta(journalTime, event.finalUpdateId, JournalSide::BID, price, quantity);
+            }
+        }
+
+        for (const auto &[price, quantity] : event.asks)
+        {
+            double previous = 0.0;
+            if (subscribers)
+            {
+                auto level = orderBook.getAsks().find(price);
+                previous = level != orderBook.getAsks().end() ? level->second : 0.0;
+            }
+
+            if (auditCapturing)
+            {
+                recordAuditDelta(event.finalUpdateId, BookSide::ASK, price, quantity);
+            }
+
+            // Levels beyond the depth bound are ignored, so neither published nor journaled
+            if (!orderBook.setAsk(price, quantity))
+            {
+                continue;
+            }
+
+            if (subscribers && previous != quantity)
+            {
+                pendingChanges.push_back(
+                    {event.finalUpdateId, receiveTimeNs, price, previous, quantity, BookSide::ASK, 0});
+            }
+
+            if (journal)
+            {
+                journal->appendDelta(journalTime, event.finalUpdateId, JournalSide::ASK, price, quantity);
+            }
+        }
+
+        // Step 4 of update procedure: Set order book update ID to u
+        orderBook.setLastUpdateId(event.finalUpdateId);
+        localUpdateId.store(event.finalUpdateId);
+
+        // Bounded-depth mode: prune, and resync once the kept levels no longer cover the bound
+        enforceDepthBound(journalTime, event.finalUpdateId);
+        if (orderBook.needsRefill())
+        {
+            refillNeeded.store(true);
+        }
+
+        if (journal && journal->isCheckpointDue())
+        {
+            journal->appendCheckpoint(journalTime, orderBook);
+        }
+
+        ORDERBOOK_ALLOC_STAGE(PUBLISH);
+        TopOfBook topAfter;
+        if (subscribers || analyticsTable)
+        {
+            topAfter = orderBook.getTopOfBook();
+        }
+
+        if (analyticsTable && topAfter != topBefore)
+        {
+            analyticsTable->update(analyticsSlot, topAfter, event.finalUpdateId);
+        }
+
+        if (viewTable)
+        {
+            viewTable->publish(viewSlot, orderBook, event.finalUpdateId, receiveTimeNs);
+        }
+
+        // Queue pushes never wait, so publishing under the lock keeps changes in book order
+        if (subscribers)
+        {
+            captureHorizons(subscribers->depths, false);
+            publishChanges(*subscribers, topBefore, topAfter);
+        }
+    }
+
+    // Trigger UI update outside the lock
     if (updateCallback)
     {
+        ORDERBOOK_ALLOC_STAGE(PUBLISH);
         updateCallback();
     }
 }
 
-DepthEvent OrderBookSynchronizer::parseDepthEvent(const std::string &jsonData) const
+void OrderBookSynchronizer::captureHorizons(const std::vector<size_t> &depths, bool before)
 {
-    DepthEvent event;
-
-    try
+    pendingHorizons.resize(depths.size());
+    for (size_t i = 0; i < depths.size(); ++i)
     {
-        Json::Value root;
-        Json::Reader reader;
-
-        if (!reader.parse(jsonData, root))
+        double bid = nthPrice(orderBook.getBids(), depths[i]);
+        double ask = nthPrice(orderBook.getAsks(), depths[i]);
+        if (before)
         {
-            return event;
+            pendingHorizons[i].bidBefore = bid;
+            pendingHorizons[i].askBefore = ask;
         }
-
-        // Handle stream format
-        Json::Value data = root.isMember("data") ? root["data"] : root;
-
-        // Extract update IDs
-        if (!data.isMember("U") || !data.isMember("u"))
+        else
         {
-            return event;
+            pendingHorizons[i].bidAfter = bid;
+            pendingHorizons[i].askAfter = ask;
         }
+    }
+}
 
-        event.firstUpdateId = data["U"].asInt64();
-        event.finalUpdateId = data["u"].asInt64();
-        event.rawJson = jsonData;
+void OrderBookSynchronizer::publishChanges(const LevelChangeHub::SubscriberList &list, const TopOfBook &before,
+                                           const TopOfBook &after)
+{
+    if (pendingChanges.empty())
+    {
+        return;
+    }
 
-        // Parse bids
-        if (data.isMember("b"))
-        {
-            Json::Value bidsArray = data["b"];
-            for (const auto &bid : bidsArray)
-            {
-                if (bid.isArray() && bid.size() >= 2)
-                {
-                    double price = std::stod(bid[0].asString());
-                    double quantity = std::stod(bid[1].asString());
-                    event.bids[price] = quantity;
-                }
-            }
-        }
+    uint8_t eventFlags = after == before ? 0 : LevelChangeFlags::BBO_CHANGED;
 
-        // Parse asks
-        if (data.isMember("a"))
+    for (LevelChange &change : pendingChanges)
+    {
+        change.flags = eventFlags;
+        bool atBest = change.side == BookSide::BID
+                          ? change.price == before.bidPrice || change.price == after.bidPrice
+                          : change.price == before.askPrice || change.price == after.askPrice;
+        if (atBest)
         {
-            Json::Value asksArray = data["a"];
-            for (const auto &ask : asksArray)
-            {
-                if (ask.isArray() && ask.size() >= 2)
-                {
-                    double price = std::stod(ask[0].asString());
-                    double quantity = std::stod(ask[1].asString());
-                    event.asks[price] = quantity;
-                }
-            }
+            change.flags |= LevelChangeFlags::AT_BBO;
         }
     }
-    catch (const std::exception &e)
+    pendingChanges.back().flags |= LevelChangeFlags::END_OF_EVENT;
+
+    changeHub.publish(list, pendingChanges, pendingHorizons);
+}
+
+void OrderBookSynchronizer::publishBookReplaced(int64_t timeNs)
+{
+    // The recorded updates no longer lead from the audit's start to this book
+    if (auditCapturing)
+    {
+        auditBroken = true;
+    }
+
+    if (analyticsTable)
+    {
+        analyticsTable->update(analyticsSlot, orderBook.getTopOfBook(), localUpdateId.load());
+    }
+    if (viewTable)
     {
-        std::cerr << "Error parsing depth event: " << e.what() << std::endl;
+        viewTable->publish(viewSlot, orderBook, localUpdateId.load(), timeNs);
     }
 
+    LevelChangeHub::Subscribers subscribers = changeHub.getSubscribers();
+    if (!subscribers)
+    {
+        return;
+    }
+
+    pendingChanges.clear();
+    pendingChanges.push_back({localUpdateId.load(), timeNs, 0.0, 0.0, 0.0, BookSide::BID,
+                              LevelChangeFlags::BOOK_REPLACED | LevelChangeFlags::END_OF_EVENT});
+    changeHub.publish(*subscribers, pendingChanges, pendingHorizons);
+}
+
+DepthEvent OrderBookSynchronizer::parseDepthEvent(std::string_view jsonData) const
+{
+    DepthEvent event;
+    parseDepthEvent(jsonData, event);
     return event;
 }
 
+bool OrderBookSynchronizer::parseDepthEvent(std::string_view jsonData, DepthEvent &event) const
+{
+    metrics.messages.add();
+
+    if (!parseDepthUpdate(jsonData, event))
+    {
+        metrics.parseFailures.add();
+        return false;
+    }
+    return true;
+}
+
 void OrderBookSynchronizer::bufferEvent(const DepthEvent &event)
 {
-    std::lock_guard<std::mutex> lock(bufferMutex);
+    ProfiledLock lock(bufferMutex);
 
-    if (eventBuffer.size() >= MAX_BUFFER_SIZE)
+    if (eventBuffer.fold(event) == NetDeltaBuffer::FoldResult::RESTARTED)
     {
-        eventBuffer.pop();
+        metrics.bufferRestarts.add();
+        LOG_WARN("{}: gap while buffering, restarting the buffer at U={}", symbol, event.firstUpdateId);
     }
 
-    eventBuffer.push(event);
+    // A snapshot must reach back to the first event of the current run
+    firstBufferedEventU.store(eventBuffer.getFirstUpdateId());
+    metrics.bufferOccupancy.set(static_cast<int64_t>(eventBuffer.getLevelCount()));
 }
 
 void OrderBookSynchronizer::clearBuffer()
 {
-    while (!eventBuffer.empty())
-    {
-        eventBuffer.pop();
-    }
+    eventBuffer.clear();
+    metrics.bufferOccupancy.set(0);
 }
 
 size_t OrderBookSynchronizer::getBufferSize() const
 {
-    std::lock_guard<std::mutex> lock(bufferMutex);
-    return eventBuffer.size();
+    ProfiledLock lock(bufferMutex);
+    return eventBuffer.getLevelCount();
 }
 
 // Data access methods
 OrderBookData OrderBookSynchronizer::getOrderBookSnapshot() const
 {
-    std::lock_guard<std::mutex> lock(orderBookMutex);
+    ProfiledLock lock(orderBookMutex);
     return orderBook;
 }
 
 std::pair<std::vector<OrderBookLevel>, std::vector<OrderBookLevel>> OrderBookSynchronizer::getTopLevels(
     int levels) const
 {
-    std::lock_guard<std::mutex> lock(orderBookMutex);
+    ProfiledLock lock(orderBookMutex);
     return std::make_pair(orderBook.getTopBids(levels), orderBook.getTopAsks(levels));
 }
 
+void OrderBookSynchronizer::copyLevelWindow(LevelWindow &window) const
+{
+    ProfiledLock lock(orderBookMutex);
+    orderBook.copyWindow(window);
+}
+
+void OrderBookSynchronizer::copyAggregatedWindow(size_t ticks, LevelWindow &window) const
+{
+    ProfiledLock lock(orderBookMutex);
+    orderBook.copyAggregatedWindow(ticks, window);
+}
+
+FillEstimate OrderBookSynchronizer::estimateFill(bool bidSide, double quantity) const
+{
+    ProfiledLock lock(orderBookMutex);
+    return orderBook.estimateFill(bidSide, quantity);
+}
+
+DepthSum OrderBookSynchronizer::depthWithinBps(bool bidSide, double bps) const
+{
+    ProfiledLock lock(orderBookMutex);
+    return orderBook.depthWithinBps(bidSide, bps);
+}
+
 // Status methods
 bool OrderBookSynchronizer::isInitialized() const
 {
@@ -432,11 +1118,26 @@ bool OrderBookSynchronizer::isSynchronized() const
     return state.load() == SyncState::SYNCHRONIZED;
 }
 
+bool OrderBookSynchronizer::isStale() const
+{
+    return stale.load();
+}
+
 SyncState OrderBookSynchronizer::getState() const
 {
     return state.load();
 }
 
+const SyncMetrics &OrderBookSynchronizer::getMetrics() const
+{
+    return metrics;
+}
+
+long long OrderBookSynchronizer::getLocalUpdateId() const
+{
+    return localUpdateId.load();
+}
+
 std::string OrderBookSynchronizer::getStateString() const
 {
     switch (state.load())
@@ -456,7 +1157,87 @@ std::string OrderBookSynchronizer::getStateString() const
     }
 }
 
+void OrderBookSynchronizer::setAnalyticsSlot(AnalyticsTable *table, size_t slot)
+{
+    ProfiledLock lock(orderBookMutex);
+    analyticsTable = table;
+    analyticsSlot = slot;
+    if (analyticsTable)
+    {
+        analyticsTable->update(analyticsSlot, orderBook.getTopOfBook(), localUpdateId.load());
+    }
+}
+
+void OrderBookSynchronizer::setViewSlot(BookViewTable *table, size_t slot)
+{
+    ProfiledLock lock(orderBookMutex);
+    viewTable = table;
+    viewSlot = slot;
+    if (viewTable)
+    {
+        viewTable->publish(viewSlot, orderBook, localUpdateId.load(), metricsNowNs());
+    }
+}
+
+SubscriptionHandle OrderBookSynchronizer::subscribe(const SubscriptionFilter &filter,
+                                                    std::function<void(const LevelChange &)> callback)
+{
+    return changeHub.subscribe(filter, std::move(callback));
+}
+
+SubscriptionHandle OrderBookSynchronizer::subscribe(const SubscriptionFilter &filter)
+{
+    return changeHub.subscribe(filter);
+}
+
+void OrderBookSynchronizer::unsubscribe(const SubscriptionHandle &subscription)
+{
+    changeHub.unsubscribe(subscription);
+}
+
 void OrderBookSynchronizer::setUpdateCallback(const std::function<void()> &callback)
 {
     updateCallback = callback;
 }
+
+void OrderBookSynchronizer::setCheckpointPath(const std::string &path)
+{
+    checkpointPath = path;
+}
+
+void OrderBookSynchronizer::setDepthBound(const DepthBound &bound)
+{
+    ProfiledLock lock(orderBookMutex);
+    orderBook.setDepthBound(bound);
+}
+
+void OrderBookSynchronizer::addAggregationView(size_t ticks)
+{
+    ProfiledLock lock(orderBookMutex);
+    orderBook.addAggregationView(ticks);
+}
+
+void OrderBookSynchronizer::setDepthIndex(size_t ticks)
+{
+    ProfiledLock lock(orderBookMutex);
+    orderBook.setDepthIndex(ticks);
+}
+
+void OrderBookSynchronizer::setJournal(BookJournal *bookJournal)
+{
+    ProfiledLock lock(orderBookMutex);
+    journal = bookJournal;
+}
+
+void OrderBookSynchronizer::setAuditInterval(std::chrono::seconds interval, bool repair)
+{
+    auditInterval = interval;
+    auditRepair = repair;
+    nextAudit = std::chrono::steady_clock::now() + interval;
+}
+
+void OrderBookSynchronizer::setDepthHistory(DepthHistory *history)
+{
+    ProfiledLock lock(orderBookMutex);
+    depthHistory = history;
+}
@@ -6,98 +6,386 @@
 #include <ftxui/component/event.hpp>
 #include <ftxui/dom/elements.hpp>
 #include <ftxui/screen/color.hpp>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
 #include <iomanip>
 #include <sstream>
+#include <string_view>
 #include <thread>
 
 using namespace ftxui;
 
+namespace
+{
+// "price | quantity" with the same precision as before, written straight into the row buffer
+size_t formatLevel(char *first, char *last, double price, double quantity)
+{
+    char *out = std::to_chars(first, last, price, std::chars_format::fixed, 2).ptr;
+
+    static constexpr std::string_view separator = " | ";
+    if (last - out > static_cast<std::ptrdiff_t>(separator.size()))
+    {
+        out = std::copy(separator.begin(), separator.end(), out);
+        out = std::to_chars(out, last, quantity, std::chars_format::fixed, 4).ptr;
+    }
+    return static_cast<size_t>(out - first);
+}
+
+// Empty cell, then four shades of liquidity
+constexpr std::array<std::string_view, 5> HEATMAP_SHADES = {" ", "\u2591", "\u2592", "\u2593", "\u2588"};
+
+// Square root scaling keeps thin levels visible next to the largest walls
+size_t heatmapShade(double quantity, double maxQuantity)
+{
+    if (quantity <= 0.0 || maxQuantity <= 0.0)
+    {
+        return 0;
+    }
+    size_t shade = 1 + static_cast<size_t>(std::sqrt(quantity / maxQuantity) * 4.0);
+    return std::min<size_t>(shade, HEATMAP_SHADES.size() - 1);
+}
+} // namespace
+
 OrderBookUI::OrderBookUI(AveragePrice &avgPrice, OrderBookManager &orderBookManager, const std::string &symbol)
     : avgPrice(avgPrice), orderBookManager(orderBookManager), symbol(symbol), screen(ScreenInteractive::Fullscreen())
 {
+    std::transform(this->symbol.begin(), this->symbol.end(), this->symbol.begin(), ::toupper);
+    resizeRows(TOP_LEVELS);
 }
 
-void OrderBookUI::start()
+size_t OrderBookUI::getVisibleRows() const
 {
-    auto component = Renderer([this] {
-        auto [price, priceChange] = avgPrice.getCurrentPrice();
-        auto [bids, asks] = orderBookManager.getTopLevels(5);
+    if (!ladderMode)
+    {
+        return TOP_LEVELS;
+    }
 
-        std::stringstream ss;
-        ss << std::fixed << std::setprecision(2) << price;
-        std::string priceStr = ss.str();
+    // Fill the terminal: asks above the mid price, bids below
+    int available = screen.dimy() - LADDER_CHROME_ROWS - static_cast<int>(feedElements.size());
+    return std::max<size_t>(TOP_LEVELS, available > 0 ? static_cast<size_t>(available) / 2 : 0);
+}
 
-        Color textColor = Color::White;
-        switch (priceChange)
-        {
-        case PriceChange::INCREASE:
-            textColor = Color::Green;
-            break;
-        case PriceChange::DECREASE:
-            textColor = Color::Red;
-            break;
-        case PriceChange::CONSTANT:
-            textColor = Color::White;
-            break;
-        }
+void OrderBookUI::resizeRows(size_t rows)
+{
+    if (window.bids.size() == rows)
+    {
+        return;
+    }
 
-        // Create orderbook display
-        Elements bidElements;
-        for (const auto &bid : bids)
-        {
-            std::stringstream bidSs;
-            bidSs << std::fixed << std::setprecision(2) << bid.getPrice() << " | " << std::setprecision(4)
-                  << bid.getQuantity();
-            bidElements.push_back(text(bidSs.str()) | color(Color::GreenLight));
-        }
+    // Only on a mode switch or terminal resize; fresh rows re-format on first use
+    window.bids.assign(rows, OrderBookLevel(0.0, 0.0));
+    window.asks.assign(rows, OrderBookLevel(0.0, 0.0));
+    bidRows.assign(rows, LadderRow{});
+    askRows.assign(rows, LadderRow{});
+}
 
-        Elements askElements;
-        for (const auto &ask : asks)
+void OrderBookUI::refreshRows(std::vector<LadderRow> &rows, const std::vector<OrderBookLevel> &levels, size_t count,
+                              Color rowColor)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        LadderRow &row = rows[i];
+        double price = levels[i].getPrice();
+        double quantity = levels[i].getQuantity();
+
+        if (row.element && row.price == price && row.quantity == quantity)
         {
-            std::stringstream askSs;
-            askSs << std::fixed << std::setprecision(2) << ask.getPrice() << " | " << std::setprecision(4)
-                  << ask.getQuantity();
-            askElements.push_back(text(askSs.str()) | color(Color::Red));
+            continue;
         }
 
-        // Combine all elements
-        Elements allElements;
+        row.price = price;
+        row.quantity = quantity;
+        row.length = formatLevel(row.buffer.data(), row.buffer.data() + row.buffer.size(), price, quantity);
+        row.element = text(std::string(row.buffer.data(), row.length)) | color(rowColor) | center;
+    }
+}
+
+void OrderBookUI::refreshMidPrice()
+{
+    auto [price, priceChange] = avgPrice.getCurrentPrice();
+    if (midPriceElement && price == lastMidPrice && priceChange == lastPriceChange)
+    {
+        return;
+    }
 
-        // Capitalize symbol for display
-        std::string capitalizedSymbol = symbol;
-        std::transform(capitalizedSymbol.begin(), capitalizedSymbol.end(), capitalizedSymbol.begin(), ::toupper);
+    lastMidPrice = price;
+    lastPriceChange = priceChange;
 
-        allElements.push_back(text(capitalizedSymbol) | bold | center);
-        allElements.push_back(separator());
+    std::array<char, ROW_BUFFER_SIZE> buffer;
+    char *end = std::to_chars(buffer.data(), buffer.data() + buffer.size(), price, std::chars_format::fixed, 2).ptr;
 
-        if (orderBookManager.isInitialized())
+    Color textColor = Color::White;
+    switch (priceChange)
+    {
+    case PriceChange::INCREASE:
+        textColor = Color::Green;
+        break;
+    case PriceChange::DECREASE:
+        textColor = Color::Red;
+        break;
+    case PriceChange::CONSTANT:
+        textColor = Color::White;
+        break;
+    }
+
+    midPriceElement =
+        hbox({text("Mid Price: "), text(std::string(buffer.data(), end)) | color(textColor) | bold}) | center;
+}
+
+void OrderBookUI::refreshFeedStats()
+{
+    // Feed stats move slowly; rebuilding them once a second keeps them off the per-update path
+    auto now = std::chrono::steady_clock::now();
+    if (!feedStatsProvider || now - lastFeedRefresh < std::chrono::milliseconds(FEED_REFRESH_MS))
+    {
+        return;
+    }
+    lastFeedRefresh = now;
+
+    feedElements.clear();
+    for (const auto &feed : feedStatsProvider())
+    {
+        std::stringstream feedSs;
+        feedSs << "Feed #" << feed.connectionId << ": " << (feed.connected ? "up" : "down") << " | win "
+               << std::fixed << std::setprecision(1) << feed.winRate * 100.0 << "% | lag " << std::setprecision(2)
+               << feed.avgLagMs << " ms";
+        feedElements.push_back(text(feedSs.str()) | dim | center);
+    }
+}
+
+void OrderBookUI::renderHeatmap(Elements &elements)
+{
+    int rows = screen.dimy() - HEATMAP_CHROME_ROWS - static_cast<int>(feedElements.size());
+    int columns = screen.dimx() - HEATMAP_LABEL_WIDTH - 4;
+    if (!depthHistory || depthHistory->getFrameCount() == 0 || rows < 2 || columns < 2)
+    {
+        elements.push_back(text("Collecting depth history...") | dim | center);
+        return;
+    }
+
+    // Price range: the deepest bid and ask the history keeps, as of the newest frame
+    double priceLow = 0.0;
+    double priceHigh = 0.0;
+    int64_t newestNs = depthHistory->getNewestTimeNs();
+    depthHistory->visitRange(newestNs, newestNs, [&](const DepthFrame &frame) {
+        priceLow = frame.bids.empty() ? 0.0 : frame.bids.back().getPrice();
+        priceHigh = frame.asks.empty() ? 0.0 : frame.asks.back().getPrice();
+    });
+    if (priceLow <= 0.0 || priceHigh <= priceLow)
+    {
+        elements.push_back(text("Collecting depth history...") | dim | center);
+        return;
+    }
+
+    int64_t spanSeconds = std::min(depthHistory->getConfig().horizonSeconds, HEATMAP_MAX_SECONDS);
+    int64_t nowNs =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    heatmap.rows = static_cast<size_t>(rows);
+    heatmap.columns = std::min(static_cast<size_t>(columns), HEATMAP_MAX_COLUMNS);
+    depthHistory->readHeatmap(nowNs - spanSeconds * 1000000000LL, nowNs, priceLow, priceHigh, heatmap);
+
+    double rowHeight = (priceHigh - priceLow) / static_cast<double>(heatmap.rows);
+    std::array<char, ROW_BUFFER_SIZE> label;
+    for (size_t row = 0; row < heatmap.rows; ++row)
+    {
+        double rowPrice = priceHigh - (static_cast<double>(row) + 0.5) * rowHeight;
+        char *end = std::to_chars(label.data(), label.data() + label.size(), rowPrice, std::chars_format::fixed, 2).ptr;
+
+        Elements cells;
+        cells.push_back(text(std::string(label.data(), end)) | dim | size(WIDTH, EQUAL, HEATMAP_LABEL_WIDTH));
+
+        // Consecutive cells with the same side and shade share one text element
+        std::string run;
+        bool runBid = false;
+        size_t runShade = 0;
+        auto flush = [&]() {
+            if (!run.empty())
+            {
+                cells.push_back(text(run) | color(runBid ? Color::GreenLight : Color::Red));
+                run.clear();
+            }
+        };
+        for (size_t column = 0; column < heatmap.columns; ++column)
         {
-            for (const auto &elem : askElements)
+            size_t cell = row * heatmap.columns + column;
+            double bidQuantity = heatmap.bidQuantity[cell];
+            double askQuantity = heatmap.askQuantity[cell];
+            bool bid = bidQuantity >= askQuantity;
+            size_t shade = heatmapShade(bid ? bidQuantity : askQuantity, heatmap.maxQuantity);
+            if (!run.empty() && (bid != runBid || shade != runShade))
             {
-                allElements.push_back(elem | center);
+                flush();
             }
+            runBid = bid;
+            runShade = shade;
+            run += HEATMAP_SHADES[shade];
+        }
+        flush();
+        elements.push_back(hbox(std::move(cells)));
+    }
 
-            allElements.push_back(text(""));
-            allElements.push_back(hbox({text("Mid Price: "), text(priceStr) | color(textColor) | bold}) | center);
-            allElements.push_back(text(""));
+    std::stringstream axisSs;
+    axisSs << "-" << spanSeconds << "s" << std::string(heatmap.columns > 8 ? heatmap.columns - 8 : 1, ' ') << "now";
+    elements.push_back(hbox({text("") | size(WIDTH, EQUAL, HEATMAP_LABEL_WIDTH), text(axisSs.str()) | dim}));
+}
 
-            for (const auto &elem : bidElements)
-            {
-                allElements.push_back(elem | center);
-            }
+void OrderBookUI::scrollToTop()
+{
+    window.bidAnchor = 0.0;
+    window.askAnchor = 0.0;
+    window.scroll = 0;
+}
+
+Element OrderBookUI::render()
+{
+    refreshFeedStats();
+    resizeRows(getVisibleRows());
+
+    if (!ladderMode)
+    {
+        scrollToTop();
+    }
+    size_t zoomTicks = ZOOM_TICKS[zoomIndex];
+    if (zoomTicks == 1)
+    {
+        orderBookManager.copyLevelWindow(window);
+    }
+    else
+    {
+        orderBookManager.copyAggregatedWindow(zoomTicks, window);
+    }
+
+    // Combine all elements
+    Elements allElements;
+    allElements.reserve(window.askCount + window.bidCount + feedElements.size() + 10);
+
+    bool stale = orderBookManager.isStale();
+    if (stale)
+    {
+        allElements.push_back(hbox({text(symbol) | bold, text(" (stale)") | dim}) | center);
+    }
+    else
+    {
+        allElements.push_back(text(symbol) | bold | center);
+    }
+    if (zoomTicks > 1 && !heatmapMode)
+    {
+        allElements.push_back(text("Grouped by " + std::to_string(zoomTicks) + " ticks") | dim | center);
+    }
+    allElements.push_back(separator());
+
+    if (heatmapMode)
+    {
+        renderHeatmap(allElements);
+    }
+    else if (orderBookManager.isInitialized() || stale)
+    {
+        refreshRows(askRows, window.asks, window.askCount, Color::Red);
+        refreshRows(bidRows, window.bids, window.bidCount, Color::GreenLight);
+        refreshMidPrice();
+
+        for (size_t i = 0; i < window.askCount; ++i)
+        {
+            allElements.push_back(askRows[i].element);
         }
-        else
+
+        allElements.push_back(text(""));
+        allElements.push_back(midPriceElement);
+        allElements.push_back(text(""));
+
+        for (size_t i = 0; i < window.bidCount; ++i)
         {
-            std::stringstream statusSs;
-            statusSs << "Loading orderbook... (bids: " << bids.size() << ", asks: " << asks.size() << ")";
-            allElements.push_back(text(statusSs.str()) | dim | center);
+            allElements.push_back(bidRows[i].element);
         }
+    }
+    else
+    {
+        std::stringstream statusSs;
+        statusSs << "Loading orderbook... (bids: " << window.totalBids << ", asks: " << window.totalAsks << ")";
+        allElements.push_back(text(statusSs.str()) | dim | center);
+    }
 
+    if (!feedElements.empty())
+    {
         allElements.push_back(separator());
-        allElements.push_back(text("Press Ctrl+C to quit") | dim | center);
+        allElements.insert(allElements.end(), feedElements.begin(), feedElements.end());
+    }
 
-        return vbox(allElements) | border | center;
-    });
+    allElements.push_back(separator());
+    if (heatmapMode)
+    {
+        allElements.push_back(text("Bids green, asks red, darker is deeper | H: back | Ctrl+C: quit") | dim | center);
+    }
+    else if (ladderMode)
+    {
+        std::stringstream footerSs;
+        footerSs << std::fixed << std::setprecision(2) << "From bid "
+                 << (window.bidCount > 0 ? window.bids[0].getPrice() : 0.0) << " / ask "
+                 << (window.askCount > 0 ? window.asks[0].getPrice() : 0.0)
+                 << " | Up/Down PgUp/PgDn Home: scroll | Z: zoom | L: top of book | Ctrl+C: quit";
+        allElements.push_back(text(footerSs.str()) | dim | center);
+    }
+    else
+    {
+        allElements.push_back(text(depthHistory ? "L: depth ladder | H: heatmap | Z: zoom | Press Ctrl+C to quit"
+                                                : "L: depth ladder | Z: zoom | Press Ctrl+C to quit") |
+                              dim | center);
+    }
+
+    return vbox(allElements) | border | center;
+}
+
+bool OrderBookUI::handleEvent(const Event &event)
+{
+    if (event == Event::Character('l') || event == Event::Character('L'))
+    {
+        ladderMode = !ladderMode;
+        scrollToTop();
+        return true;
+    }
+
+    if (event == Event::Character('z') || event == Event::Character('Z'))
+    {
+        zoomIndex = (zoomIndex + 1) % ZOOM_TICKS.size();
+        scrollToTop();
+        return true;
+    }
+
+    if (depthHistory && (event == Event::Character('h') || event == Event::Character('H')))
+    {
+        heatmapMode = !heatmapMode;
+        return true;
+    }
+
+    if (!ladderMode || heatmapMode)
+    {
+        return false;
+    }
+
+    // The next copy moves the anchors and stops at either end of the book
+    long page = static_cast<long>(window.bids.size());
+
+    if (event == Event::ArrowDown)
+        window.scroll += 1;
+    else if (event == Event::ArrowUp)
+        window.scroll -= 1;
+    else if (event == Event::PageDown)
+        window.scroll += page;
+    else if (event == Event::PageUp)
+        window.scroll -= page;
+    else if (event == Event::Home)
+        scrollToTop();
+    else
+        return false;
+
+    return true;
+}
+
+void OrderBookUI::start()
+{
+    auto component = Renderer([this] { return render(); });
 
     // Create a component that handles Ctrl+C
     auto main_component = CatchEvent(component, [&](Event event) {
@@ -107,7 +395,7 @@ void OrderBookUI::start()
             screen.ExitLoopClosure()();
             return true;
         }
-        return false;
+        return handleEvent(event);
     });
 
     // Set up callbacks for UI updates
@@ -142,6 +430,16 @@ void OrderBookUI::start()
     }
 }
 
+void OrderBookUI::setFeedStatsProvider(const std::function<std::vector<FeedConnectionStats>()> &provider)
+{
+    feedStatsProvider = provider;
+}
+
+void OrderBookUI::setDepthHistory(const DepthHistory *history)
+{
+    depthHistory = history;
+}
+
 void OrderBookUI::stop()
 {
     screen.ExitLoopClosure()();
@@ -0,0 +1,184 @@
+#include "ProfiledMutex.h"
+
+#ifdef ORDERBOOK_LOCK_PROFILING
+
+#include "FeedMetrics.h"
+#include <iomanip>
+
+namespace
+{
+size_t bucketFor(uint64_t ns)
+{
+    size_t bucket = ns == 0 ? 0 : 63 - __builtin_clzll(ns);
+    return bucket < LockStats::BUCKETS ? bucket : LockStats::BUCKETS - 1;
+}
+
+// Upper edge of the bucket holding the given percentile, in ns
+uint64_t percentile(const std::array<std::atomic<uint64_t>, LockStats::BUCKETS> &histogram, double fraction)
+{
+    uint64_t total = 0;
+    for (const auto &count : histogram)
+    {
+        total += count.load(std::memory_order_relaxed);
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    uint64_t target = static_cast<uint64_t>(total * fraction);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LockStats::BUCKETS; ++i)
+    {
+        seen += histogram[i].load(std::memory_order_relaxed);
+        if (seen > target)
+        {
+            return uint64_t(1) << (i + 1);
+        }
+    }
+    return uint64_t(1) << LockStats::BUCKETS;
+}
+
+void writeDuration(std::ostream &out, uint64_t ns)
+{
+    out << std::setw(10) << std::fixed << std::setprecision(1) << ns / 1e3 << "us";
+}
+} // namespace
+
+// LockStats
+
+void LockStats::recordWait(uint64_t waitNs)
+{
+    acquisitions.fetch_add(1, std::memory_order_relaxed);
+    waitTotalNs.fetch_add(waitNs, std::memory_order_relaxed);
+    waitHistogram[bucketFor(waitNs)].fetch_add(1, std::memory_order_relaxed);
+    if (waitNs > 0)
+    {
+        contended.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void LockStats::recordHold(uint64_t holdNs, const char *file, int line)
+{
+    holdTotalNs.fetch_add(holdNs, std::memory_order_relaxed);
+    holdHistogram[bucketFor(holdNs)].fetch_add(1, std::memory_order_relaxed);
+
+    if (holdNs > maxHoldNs.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(maxHoldMutex);
+        if (holdNs > maxHoldNs.load(std::memory_order_relaxed))
+        {
+            maxHoldNs.store(holdNs, std::memory_order_relaxed);
+            maxHoldFile = file;
+            maxHoldLine = line;
+        }
+    }
+}
+
+// LockProfiler
+
+LockProfiler &LockProfiler::instance()
+{
+    static LockProfiler profiler;
+    return profiler;
+}
+
+LockStats &LockProfiler::getStats(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    auto &stats = locks[name];
+    if (!stats)
+    {
+        stats = std::make_unique<LockStats>();
+        stats->name = name;
+    }
+    return *stats;
+}
+
+void LockProfiler::writeReport(std::ostream &out)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    out << "Lock profile (wait / hold, bucket upper bounds)\n";
+    for (const auto &[name, stats] : locks)
+    {
+        uint64_t acquisitions = stats->acquisitions.load();
+        if (acquisitions == 0)
+        {
+            continue;
+        }
+
+        out << name << ": " << acquisitions << " acquisitions, " << stats->contended.load() << " contended\n";
+
+        out << "  wait  avg";
+        writeDuration(out, stats->waitTotalNs.load() / acquisitions);
+        out << "  p50";
+        writeDuration(out, percentile(stats->waitHistogram, 0.50));
+        out << "  p99";
+        writeDuration(out, percentile(stats->waitHistogram, 0.99));
+        out << "\n";
+
+        out << "  hold  avg";
+        writeDuration(out, stats->holdTotalNs.load() / acquisitions);
+        out << "  p50";
+        writeDuration(out, percentile(stats->holdHistogram, 0.50));
+        out << "  p99";
+        writeDuration(out, percentile(stats->holdHistogram, 0.99));
+        out << "\n";
+
+        std::lock_guard<std::mutex> maxLock(stats->maxHoldMutex);
+        out << "  longest hold";
+        writeDuration(out, stats->maxHoldNs.load());
+        out << " at " << stats->maxHoldFile << ":" << stats->maxHoldLine << "\n";
+    }
+}
+
+// ProfiledMutex
+
+ProfiledMutex::ProfiledMutex(const char *name) : stats(LockProfiler::instance().getStats(name))
+{
+}
+
+void ProfiledMutex::lock(const char *file, int line)
+{
+    uint64_t waitNs = 0;
+    if (!mutex.try_lock())
+    {
+        int64_t start = metricsNowNs();
+        mutex.lock();
+        waitNs = metricsNowNs() - start;
+    }
+
+    stats.recordWait(waitNs);
+    acquiredNs = metricsNowNs();
+    ownerFile = file;
+    ownerLine = line;
+}
+
+bool ProfiledMutex::try_lock()
+{
+    if (!mutex.try_lock())
+    {
+        return false;
+    }
+
+    stats.recordWait(0);
+    acquiredNs = metricsNowNs();
+    ownerFile = "try_lock";
+    ownerLine = 0;
+    return true;
+}
+
+void ProfiledMutex::unlock()
+{
+    // Read the owner fields before another thread can take the lock
+    uint64_t holdNs = metricsNowNs() - acquiredNs;
+    const char *file = ownerFile;
+    int line = ownerLine;
+
+    mutex.unlock();
+    stats.recordHold(holdNs, file, line);
+}
+
+#endif
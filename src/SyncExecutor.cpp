@@ -0,0 +1,109 @@
+#include "SyncExecutor.h"
+
+SyncExecutor &SyncExecutor::instance()
+{
+    static SyncExecutor executor;
+    return executor;
+}
+
+SyncExecutor::SyncExecutor()
+{
+    for (size_t i = 0; i < WORKER_THREADS; ++i)
+    {
+        workers.emplace_back(&SyncExecutor::workerLoop, this);
+    }
+}
+
+SyncExecutor::~SyncExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        running = false;
+    }
+    queueCondition.notify_all();
+
+    for (auto &worker : workers)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+}
+
+void SyncExecutor::post(std::coroutine_handle<> handle)
+{
+    post([handle]() { handle.resume(); });
+}
+
+void SyncExecutor::post(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        ready.push_back(std::move(task));
+    }
+    queueCondition.notify_one();
+}
+
+void SyncExecutor::postAt(Clock::time_point deadline, std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        timers.push(Timer{deadline, timerSequence++, std::move(task)});
+    }
+    // The new timer may be earlier than the one the workers are sleeping towards
+    queueCondition.notify_one();
+}
+
+void SyncExecutor::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(queueMutex);
+
+    while (running)
+    {
+        // Move due timers onto the ready queue
+        auto now = Clock::now();
+        while (!timers.empty() && timers.top().deadline <= now)
+        {
+            ready.push_back(std::move(const_cast<Timer &>(timers.top()).task));
+            timers.pop();
+        }
+
+        if (ready.empty())
+        {
+            if (timers.empty())
+            {
+                queueCondition.wait(lock);
+            }
+            else
+            {
+                queueCondition.wait_until(lock, timers.top().deadline);
+            }
+            continue;
+        }
+
+        std::function<void()> task = std::move(ready.front());
+        ready.pop_front();
+
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+void AsyncSignal::notify()
+{
+    std::coroutine_handle<> waiter;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (!state->waiter)
+        {
+            state->pending = true;
+            return;
+        }
+        waiter = std::exchange(state->waiter, nullptr);
+    }
+
+    // Resume on the executor so the notifying thread (e.g. the feed) is never borrowed
+    SyncExecutor::instance().post(waiter);
+}
@@ -1,20 +1,23 @@
-#include "OrderBook.h"
 #include "WebSocket.h"
+#include "AllocationTracker.h"
+#include "AsyncLogger.h"
+#include "OrderBookSynchronizer.h"
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <chrono>
+#include <future>
 #include <json/json.h>
+#include <string_view>
 #include <websocketpp/client.hpp>
 #include <websocketpp/close.hpp>
 #include <websocketpp/common/connection_hdl.hpp>
 #include <websocketpp/config/asio_client.hpp>
 
-typedef websocketpp::client<websocketpp::config::asio_tls_client> client;
+typedef websocketpp::client<PooledTlsClientConfig> client;
 typedef websocketpp::lib::shared_ptr<websocketpp::lib::asio::ssl::context> context_ptr;
 
-WebSocket::WebSocket(AveragePrice &avgPrice, OrderBookManager &orderBookManager, OrderBookSynchronizer &synchronizer,
-                     const std::string &tradingSymbol)
-    : running(false), avgPrice(avgPrice), orderBookManager(orderBookManager), synchronizer(synchronizer),
-      symbol(tradingSymbol)
+WebSocket::WebSocket(size_t feedConnections) : running(false), replicas(feedConnections)
 {
     ws_client.set_access_channels(websocketpp::log::alevel::all);
     ws_client.clear_access_channels(websocketpp::log::alevel::frame_payload);
@@ -24,82 +27,493 @@ WebSocket::WebSocket(AveragePrice &avgPrice, OrderBookManager &orderBookManager,
         return websocketpp::lib::make_shared<websocketpp::lib::asio::ssl::context>(
             websocketpp::lib::asio::ssl::context::sslv23);
     });
+}
+
+std::string WebSocket::normalizeSymbol(const std::string &symbol)
+{
+    std::string lowerSymbol = symbol;
+    std::transform(lowerSymbol.begin(), lowerSymbol.end(), lowerSymbol.begin(), ::tolower);
+    return lowerSymbol;
+}
+
+void WebSocket::runOnFeedThread(const std::function<void()> &task)
+{
+    // Before start() nothing else touches the routes
+    if (!running.load())
+    {
+        task();
+        return;
+    }
+
+    // Otherwise the change runs on the WebSocket thread between two frames, so on_message never
+    // sees it half done and no handler of a removed route is still running when this returns.
+    // Whichever side claims the task runs it, and the handler only touches it after claiming, so
+    // the caller may return while an aborted or late handler is still queued.
+    auto done = std::make_shared<std::promise<void>>();
+    auto claimed = std::make_shared<std::atomic<bool>>(false);
+    std::future<void> finished = done->get_future();
+    ws_client.set_timer(0, [&task, done, claimed](const websocketpp::lib::error_code &ec) {
+        // Aborted when the client stops; the caller then runs the task itself
+        if (!ec && !claimed->exchange(true))
+        {
+            task();
+        }
+        done->set_value();
+    });
+
+    while (finished.wait_for(std::chrono::milliseconds(FEED_TASK_POLL_MS)) != std::future_status::ready)
+    {
+        // The loop has stopped, or is stopping, and won't get to the handler
+        if (!running.load() || ws_client.stopped())
+        {
+            break;
+        }
+    }
+    if (!claimed->exchange(true))
+    {
+        task();
+    }
+    else
+    {
+        finished.wait(); // The handler claimed it first and is running it
+    }
+}
+
+size_t WebSocket::assignGroup()
+{
+    for (size_t group = 0; group < groups.size(); ++group)
+    {
+        if (groups[group].streams < STREAMS_PER_CONNECTION)
+        {
+            return group;
+        }
+    }
+    groups.emplace_back();
+    return groups.size() - 1;
+}
+
+std::vector<std::string> WebSocket::groupStreams(size_t group) const
+{
+    std::vector<std::string> streams;
+    for (const auto &route : routes)
+    {
+        if (route->group == group)
+        {
+            streams.push_back(route->name);
+        }
+    }
+    return streams;
+}
+
+std::vector<std::string> WebSocket::uriStreams(const std::string &uri)
+{
+    // Inverse of groupUri: the names after "?streams=", separated by '/'
+    std::vector<std::string> streams;
+    size_t start = uri.find("?streams=");
+    if (start == std::string::npos)
+    {
+        return streams;
+    }
+    start += std::string_view("?streams=").size();
+    while (start < uri.size())
+    {
+        size_t end = uri.find('/', start);
+        if (end == std::string::npos)
+        {
+            end = uri.size();
+        }
+        streams.push_back(uri.substr(start, end - start));
+        start = end + 1;
+    }
+    return streams;
+}
+
+std::string WebSocket::groupUri(size_t group) const
+{
+    // A group whose streams were all removed stays connected to the bare endpoint
+    std::string uri = endpoint;
+    char separator = '?';
+    for (const auto &route : routes)
+    {
+        if (route->group == group)
+        {
+            uri += separator == '?' ? "?streams=" : "/";
+            uri += route->name;
+            separator = '/';
+        }
+    }
+    return uri;
+}
+
+void WebSocket::addRoute(std::unique_ptr<StreamRoute> route)
+{
+    runOnFeedThread([this, &route]() {
+        if (routeTable.count(route->name) > 0)
+        {
+            return; // Already routed
+        }
+
+        size_t groupCount = groups.size();
+        size_t group = assignGroup();
+        bool newGroup = group == groupCount;
+        StreamRoute &ref = *route;
+        ref.group = group;
+        {
+            std::lock_guard<std::mutex> lock(routeMutex);
+            routes.push_back(std::move(route));
+            routeTable[std::string_view(ref.name)] = &ref;
+        }
+        groups[group].streams++;
+
+        if (!running.load())
+        {
+            return; // start() opens every group
+        }
+        if (newGroup)
+        {
+            openGroup(group);
+            return;
+        }
+
+        if (ref.arbiter)
+        {
+            std::lock_guard<std::mutex> lock(slotMutex);
+            for (const auto &slot : slots)
+            {
+                if (slot.group == group)
+                {
+                    ref.arbiter->setConnected(slot.replica, slot.open);
+                }
+            }
+        }
+        queueControl(group, ref.name, true);
+    });
+}
+
+bool WebSocket::removeRoute(const std::string &stream)
+{
+    auto it = routeTable.find(std::string_view(stream));
+    if (it == routeTable.end())
+    {
+        return false;
+    }
+
+    StreamRoute *route = it->second;
+    size_t group = route->group;
+    {
+        std::lock_guard<std::mutex> lock(routeMutex);
+        routeTable.erase(it);
+        routes.erase(std::find_if(routes.begin(), routes.end(), [route](const auto &owned) {
+            return owned.get() == route;
+        }));
+    }
+    groups[group].streams--;
+
+    // Frames already in flight for the stream now find no route and are dropped
+    if (running.load())
+    {
+        queueControl(group, stream, false);
+    }
+    return true;
+}
+
+void WebSocket::addStream(const std::string &stream, StreamHandler handler)
+{
+    auto route = std::make_unique<StreamRoute>();
+    route->name = stream;
+    route->handler = std::move(handler);
+    addRoute(std::move(route));
+}
+
+bool WebSocket::removeStream(const std::string &stream)
+{
+    bool removed = false;
+    runOnFeedThread([this, &stream, &removed]() { removed = removeRoute(stream); });
+    return removed;
+}
+
+void WebSocket::removeSymbol(const std::string &symbol)
+{
+    std::string name = normalizeSymbol(symbol);
+    removeStream(name + "@depth");
+    removeStream(name + "@bookTicker");
+}
+
+void WebSocket::addDepthStream(const std::string &symbol, OrderBookSynchronizer &synchronizer)
+{
+    auto route = std::make_unique<StreamRoute>();
+    route->name = normalizeSymbol(symbol) + "@depth";
+    route->arbiter = std::make_unique<FeedArbiter>(replicas);
+
+    FeedArbiter *arbiter = route->arbiter.get();
+    auto event = std::make_shared<DepthEvent>(); // Reused; only the WebSocket thread runs handlers
+    route->handler = [arbiter, event, &synchronizer](size_t replica, std::string_view payload) {
+        ORDERBOOK_ALLOC_MESSAGE();
+
+        // Parse once; only the first copy of each update across the replicas is applied
+        {
+            ORDERBOOK_ALLOC_STAGE(PARSE);
+            synchronizer.parseDepthEvent(payload, *event);
+        }
+        if (event->finalUpdateId != 0 && arbiter->arbitrate(replica, event->finalUpdateId))
+        {
+            synchronizer.processDepthEvent(*event);
+        }
+    };
+    addRoute(std::move(route));
+}
+
+void WebSocket::addBookTickerStream(const std::string &symbol, AveragePrice &avgPrice)
+{
+    auto lastUpdateId = std::make_shared<std::atomic<long long>>(0);
+
+    addStream(normalizeSymbol(symbol) + "@bookTicker", [&avgPrice, lastUpdateId](size_t, std::string_view payload) {
+        Json::Value root;
+        Json::Reader reader;
+        if (!reader.parse(payload.data(), payload.data() + payload.size(), root))
+        {
+            return;
+        }
+
+        const Json::Value &data = root["data"];
+        long long updateId = data["u"].asInt64();
+
+        // Replicas deliver the same ticks; only move the price forward
+        if (updateId <= lastUpdateId->load())
+        {
+            return;
+        }
+        lastUpdateId->store(updateId);
+
+        double bestBid = std::stod(data["b"].asString());
+        double bestAsk = std::stod(data["a"].asString());
+        avgPrice.updatePrice((bestBid + bestAsk) / 2.0);
+    });
+}
 
-    ws_client.set_message_handler([this](websocketpp::connection_hdl, client::message_ptr msg) { on_message(msg); });
+std::string_view WebSocket::extractStreamName(std::string_view payload)
+{
+    // Combined-stream frames always start with {"stream":"<name>", so the name is read in place
+    static constexpr std::string_view prefix = "{\"stream\":\"";
 
-    ws_client.set_open_handler([this](websocketpp::connection_hdl hdl) { on_open(hdl); });
+    if (payload.substr(0, prefix.size()) != prefix)
+    {
+        return {};
+    }
 
-    ws_client.set_close_handler([this](websocketpp::connection_hdl) { on_close(); });
+    size_t end = payload.find('"', prefix.size());
+    if (end == std::string_view::npos)
+    {
+        return {};
+    }
 
-    ws_client.set_fail_handler([this](websocketpp::connection_hdl) { on_fail(); });
+    return payload.substr(prefix.size(), end - prefix.size());
 }
 
-void WebSocket::on_message(client::message_ptr msg)
+void WebSocket::on_message(size_t slotIndex, client::message_ptr msg)
 {
     // Check if shutdown was requested
-    if (!g_running.load())
+    if (!running.load())
     {
         // Don't call stop() from within the callback to avoid deadlock
         // Just return and let the main thread handle shutdown
         return;
     }
 
-    std::string payload = msg->get_payload();
+    // View into the pooled frame buffer; it stays valid until msg is released
+    const std::string &frame = msg->get_payload();
+    std::string_view payload(frame.data(), frame.size());
+
+    std::string_view stream = extractStreamName(payload);
+    auto it = routeTable.find(stream);
+    if (it == routeTable.end())
+    {
+        // Subscription acks, and frames of streams removed since they were sent
+        if (stream.empty() && payload.find("\"error\"") != std::string_view::npos)
+        {
+            LOG_WARN("Feed control request rejected: {}", payload);
+        }
+        return;
+    }
 
     try
     {
-        Json::Value root;
-        Json::Reader reader;
+        it->second->handler(slots[slotIndex].replica, payload);
+    }
+    catch (const std::exception &e)
+    {
+        // Silently handle errors to avoid UI glitching
+    }
+}
 
-        if (reader.parse(payload, root))
+void WebSocket::setReplicaConnected(size_t slotIndex, bool connected)
+{
+    ConnectionSlot &slot = slots[slotIndex];
+    {
+        std::lock_guard<std::mutex> lock(slotMutex);
+        slot.open = connected;
+    }
+    for (const auto &route : routes)
+    {
+        if (route->arbiter && route->group == slot.group)
         {
-            // Check if this is a stream message (combined streams format)
-            if (root.isMember("stream") && root.isMember("data"))
-            {
-                std::string stream = root["stream"].asString();
+            route->arbiter->setConnected(slot.replica, connected);
+        }
+    }
+}
+
+void WebSocket::on_open(size_t slotIndex, websocketpp::connection_hdl hdl)
+{
+    {
+        std::lock_guard<std::mutex> lock(slotMutex);
+        ConnectionSlot &slot = slots[slotIndex];
+        slot.hdl = hdl;
 
-                // Handle depth stream only - process through synchronizer
-                if (stream.find("@depth") != std::string::npos)
+        // Streams added or removed while this connection was opening are missing from, or still
+        // in, its URI; the flush skipped it because it wasn't open yet
+        if (slot.uri != groupUri(slot.group))
+        {
+            std::vector<std::string> opened = uriStreams(slot.uri);
+            std::vector<std::string> current = groupStreams(slot.group);
+            std::vector<std::string> missing;
+            std::vector<std::string> extra;
+            for (const auto &stream : current)
+            {
+                if (std::find(opened.begin(), opened.end(), stream) == opened.end())
+                {
+                    missing.push_back(stream);
+                }
+            }
+            for (const auto &stream : opened)
+            {
+                if (std::find(current.begin(), current.end(), stream) == current.end())
                 {
-                    synchronizer.processDepthEvent(payload);
-                    updateMidPrice();
+                    extra.push_back(stream);
                 }
             }
-            // Handle direct depth stream format (single stream)
-            else if (root.isMember("U") && root.isMember("u") && root.isMember("b") && root.isMember("a"))
+            if (!missing.empty())
             {
-                // This is a direct depth update, not wrapped in stream format
-                synchronizer.processDepthEvent(payload);
-                updateMidPrice();
+                sendControl(hdl, "SUBSCRIBE", missing);
             }
-            // Fallback for direct bookTicker stream (old format)
-            else if (root.isMember("b") && root.isMember("a"))
+            if (!extra.empty())
             {
-                double bestBid = std::stod(root["b"].asString());
-                double bestAsk = std::stod(root["a"].asString());
-                double midPrice = (bestBid + bestAsk) / 2.0;
-                avgPrice.updatePrice(midPrice);
+                sendControl(hdl, "UNSUBSCRIBE", extra);
             }
         }
     }
-    catch (const std::exception &e)
+    setReplicaConnected(slotIndex, true);
+}
+
+void WebSocket::queueControl(size_t group, const std::string &stream, bool subscribe)
+{
+    StreamGroup &target = groups[group];
+    std::vector<std::string> &queue = subscribe ? target.pendingSubscribe : target.pendingUnsubscribe;
+    std::vector<std::string> &opposite = subscribe ? target.pendingUnsubscribe : target.pendingSubscribe;
+
+    // A change that undoes a pending one cancels it, so the pair sends nothing: the stream was
+    // never subscribed, or never left
+    if (std::erase(opposite, stream) == 0)
     {
-        // Silently handle errors to avoid UI glitching
+        queue.push_back(stream);
+    }
+
+    // Changes within one interval share a message, which keeps every connection under the limit
+    if (!flushScheduled)
+    {
+        flushScheduled = true;
+        ws_client.set_timer(CONTROL_FLUSH_MS, [this](const websocketpp::lib::error_code &ec) {
+            flushScheduled = false;
+            if (!ec && running.load())
+            {
+                flushControl();
+            }
+        });
     }
 }
 
-void WebSocket::on_open(websocketpp::connection_hdl hdl)
+void WebSocket::flushControl()
 {
-    this->hdl = hdl;
+    std::lock_guard<std::mutex> lock(slotMutex);
+    for (size_t group = 0; group < groups.size(); ++group)
+    {
+        StreamGroup &pending = groups[group];
+        for (const auto &slot : slots)
+        {
+            // A closed replica reconnects with the group's current streams in its URI
+            if (slot.group != group || !slot.open)
+            {
+                continue;
+            }
+            if (!pending.pendingSubscribe.empty())
+            {
+                sendControl(slot.hdl, "SUBSCRIBE", pending.pendingSubscribe);
+            }
+            if (!pending.pendingUnsubscribe.empty())
+            {
+                sendControl(slot.hdl, "UNSUBSCRIBE", pending.pendingUnsubscribe);
+            }
+        }
+        pending.pendingSubscribe.clear();
+        pending.pendingUnsubscribe.clear();
+    }
 }
 
-void WebSocket::on_close()
+void WebSocket::sendControl(websocketpp::connection_hdl hdl, const char *method,
+                            const std::vector<std::string> &streams)
 {
+    std::string request = std::string("{\"method\":\"") + method + "\",\"params\":[";
+    for (size_t i = 0; i < streams.size(); ++i)
+    {
+        request += (i == 0 ? "\"" : ",\"") + streams[i] + "\"";
+    }
+    request += "],\"id\":" + std::to_string(nextRequestId++) + "}";
+
+    websocketpp::lib::error_code ec;
+    ws_client.send(hdl, request, websocketpp::frame::opcode::text, ec);
+    if (ec)
+    {
+        LOG_WARN("Feed {} failed: {}", method, ec.message());
+    }
 }
 
-void WebSocket::on_fail()
+void WebSocket::on_close(size_t slotIndex)
 {
+    setReplicaConnected(slotIndex, false);
+    scheduleReconnect(slotIndex);
+}
+
+void WebSocket::on_fail(size_t slotIndex)
+{
+    setReplicaConnected(slotIndex, false);
+    scheduleReconnect(slotIndex);
+}
+
+void WebSocket::scheduleReconnect(size_t slotIndex)
+{
+    if (!running.load())
+    {
+        return;
+    }
+
+    // The other replicas keep feeding the books while this one comes back
+    ws_client.set_timer(RECONNECT_DELAY_MS, [this, slotIndex](const websocketpp::lib::error_code &ec) {
+        if (ec || !running.load())
+        {
+            return;
+        }
+
+        const ConnectionSlot &slot = slots[slotIndex];
+        for (const auto &route : routes)
+        {
+            if (route->arbiter && route->group == slot.group)
+            {
+                route->arbiter->recordReconnect(slot.replica);
+            }
+        }
+        connect(slotIndex);
+    });
 }
+
 context_ptr WebSocket::on_tls_init(websocketpp::connection_hdl hdl)
 {
     context_ptr ctx = websocketpp::lib::make_shared<websocketpp::lib::asio::ssl::context>(
@@ -129,10 +543,17 @@ void WebSocket::stop()
 
     running.store(false);
 
-    websocketpp::lib::error_code ec;
-    ws_client.close(hdl, websocketpp::close::status::going_away, "", ec);
+    {
+        std::lock_guard<std::mutex> lock(slotMutex);
+        for (auto &slot : slots)
+        {
+            websocketpp::lib::error_code ec;
+            ws_client.close(slot.hdl, websocketpp::close::status::going_away, "", ec);
+        }
+    }
 
     // Stop the client to exit the event loop
+    ws_client.stop_perpetual();
     ws_client.stop();
 
     if (ws_thread.joinable())
@@ -142,19 +563,62 @@ void WebSocket::stop()
     }
 }
 
-void WebSocket::updateMidPrice()
+std::vector<FeedConnectionStats> WebSocket::getFeedStats(const std::string &symbol) const
+{
+    std::lock_guard<std::mutex> lock(routeMutex);
+    auto it = routeTable.find(normalizeSymbol(symbol) + "@depth");
+    if (it == routeTable.end() || !it->second->arbiter)
+    {
+        return {};
+    }
+    return it->second->arbiter->getStats();
+}
+
+void WebSocket::connect(size_t slotIndex)
+{
+    std::string uri;
+    {
+        std::lock_guard<std::mutex> lock(slotMutex);
+        ConnectionSlot &slot = slots[slotIndex];
+        slot.uri = groupUri(slot.group);
+        uri = slot.uri;
+    }
+
+    websocketpp::lib::error_code ec;
+    client::connection_ptr con = ws_client.get_connection(uri, ec);
+
+    if (ec)
+    {
+        scheduleReconnect(slotIndex);
+        return;
+    }
+
+    con->set_message_handler(
+        [this, slotIndex](websocketpp::connection_hdl, client::message_ptr msg) { on_message(slotIndex, msg); });
+    con->set_open_handler([this, slotIndex](websocketpp::connection_hdl hdl) { on_open(slotIndex, hdl); });
+    con->set_close_handler([this, slotIndex](websocketpp::connection_hdl) { on_close(slotIndex); });
+    con->set_fail_handler([this, slotIndex](websocketpp::connection_hdl) { on_fail(slotIndex); });
+
+    ws_client.connect(con);
+}
+
+void WebSocket::openGroup(size_t group)
 {
-    if (synchronizer.isSynchronized())
+    // One combined-stream URI per group of streams, carried by every replica
+    size_t first = 0;
     {
-        auto [bids, asks] = synchronizer.getTopLevels(1);
-        if (!bids.empty() && !asks.empty())
+        std::lock_guard<std::mutex> lock(slotMutex);
+        first = slots.size();
+        for (size_t replica = 0; replica < replicas; ++replica)
         {
-            double bestBid = bids[0].getPrice();
-            double bestAsk = asks[0].getPrice();
-            double midPrice = (bestBid + bestAsk) / 2.0;
-            avgPrice.updatePrice(midPrice);
+            slots.push_back(ConnectionSlot{group, replica, {}, {}});
         }
     }
+
+    for (size_t i = first; i < first + replicas; ++i)
+    {
+        connect(i);
+    }
 }
 
 void WebSocket::start()
@@ -164,19 +628,15 @@ void WebSocket::start()
 
     running.store(true);
 
-    std::string lowerSymbol = symbol;
-    std::transform(lowerSymbol.begin(), lowerSymbol.end(), lowerSymbol.begin(), ::tolower);
-    std::string depth_uri = baseUri + lowerSymbol + "@depth";
-
-    websocketpp::lib::error_code ec;
-    client::connection_ptr con = ws_client.get_connection(depth_uri, ec);
+    // Keep the event loop alive while every connection is down and waiting to reconnect, and
+    // while there are no streams yet
+    ws_client.start_perpetual();
 
-    if (ec)
+    slots.clear();
+    for (size_t group = 0; group < groups.size(); ++group)
     {
-        return;
+        openGroup(group);
     }
 
-    ws_client.connect(con);
-
     ws_thread = std::thread([this]() { ws_client.run(); });
 }
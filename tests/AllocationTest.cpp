@@ -0,0 +1,168 @@
+#include "AllocationTracker.h"
+#include "AnalyticsTable.h"
+#include "BookViewTable.h"
+#include "OrderBookSynchronizer.h"
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Replays synthetic depth traffic through a synchronized book and fails if the steady-state
+// message path allocates. Needs a build configured with -DORDERBOOK_ALLOC_TRACKING=ON.
+//
+//   alloc_check [messages] [warmup messages]
+//
+// Frames go through the same steps as the feed handler: parse into a reused event, sequence,
+// apply (with the depth history sampling and depth index), and publish to a polled subscriber,
+// the analytics table and the multi-book views.
+
+namespace
+{
+constexpr double MID = 100.0;
+constexpr double TICK = 0.01;
+constexpr int BOOK_LEVELS = 1000; // Per side; updates stay inside this band so depth is stable
+constexpr int LEVELS_PER_UPDATE = 12;
+
+std::string formatDecimal(double value)
+{
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%.8f", value);
+    return std::string(buffer, length);
+}
+
+DepthSnapshot makeSnapshot(long long lastUpdateId)
+{
+    DepthSnapshot snapshot;
+    for (int i = 1; i <= BOOK_LEVELS; ++i)
+    {
+        snapshot.bids[MID - i * TICK] = 1.0 + i % 7;
+        snapshot.asks[MID + i * TICK] = 1.0 + i % 5;
+    }
+    snapshot.lastUpdateId = lastUpdateId;
+    snapshot.isValid = true;
+    return snapshot;
+}
+
+// Combined-stream depthUpdate frames, built up front so only the replay is measured. Each level
+// is set or removed at random, so levels keep appearing and disappearing around a stable depth.
+std::vector<std::string> makeFrames(size_t count, long long firstUpdateId)
+{
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> offset(1, BOOK_LEVELS);
+    std::uniform_int_distribution<int> action(0, 3);
+
+    std::vector<std::string> frames;
+    frames.reserve(count);
+    long long updateId = firstUpdateId;
+    for (size_t n = 0; n < count; ++n)
+    {
+        long long first = updateId + 1;
+        updateId += LEVELS_PER_UPDATE;
+
+        std::string frame = "{\"stream\":\"testusdt@depth\",\"data\":{\"e\":\"depthUpdate\",\"E\":" +
+                            std::to_string(1700000000000 + n) + ",\"s\":\"TESTUSDT\",\"U\":" +
+                            std::to_string(first) + ",\"u\":" + std::to_string(updateId) + ",\"b\":[";
+        for (int side = 0; side < 2; ++side)
+        {
+            for (int i = 0; i < LEVELS_PER_UPDATE / 2; ++i)
+            {
+                int level = offset(random);
+                double price = side == 0 ? MID - level * TICK : MID + level * TICK;
+                double quantity = action(random) == 0 ? 0.0 : 0.5 + (level % 13) * 0.25;
+                frame += i == 0 ? "[\"" : ",[\"";
+                frame += formatDecimal(price) + "\",\"" + formatDecimal(quantity) + "\"]";
+            }
+            frame += side == 0 ? "],\"a\":[" : "]}}";
+        }
+        frames.push_back(std::move(frame));
+    }
+    return frames;
+}
+
+void printReport(const AllocationStats &stats)
+{
+    std::cout << std::left << std::setw(10) << "stage" << std::right << std::setw(14) << "allocations"
+              << std::setw(14) << "bytes" << std::setw(14) << "per message" << "\n";
+    for (size_t i = 0; i < stats.stages.size(); ++i)
+    {
+        const AllocationStageStats &stage = stats.stages[i];
+        double perMessage = stats.messages ? static_cast<double>(stage.allocations) / stats.messages : 0.0;
+        std::cout << std::left << std::setw(10) << allocationStageName(static_cast<AllocationStage>(i))
+                  << std::right << std::setw(14) << stage.allocations << std::setw(14) << stage.bytes
+                  << std::setw(14) << std::fixed << std::setprecision(3) << perMessage << "\n";
+    }
+    std::cout << "messages " << stats.messages << ", with allocations " << stats.messagesWithAllocations
+              << ", worst message " << stats.maxAllocationsPerMessage << " allocations" << std::endl;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (!AllocationTracker::ENABLED)
+    {
+        std::cerr << "alloc_check needs a build configured with -DORDERBOOK_ALLOC_TRACKING=ON" << std::endl;
+        return 2;
+    }
+
+    size_t messages = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    size_t warmup = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20000;
+
+    const long long snapshotId = 1000;
+    std::vector<std::string> frames = makeFrames(warmup + messages, snapshotId);
+
+    OrderBookSynchronizer synchronizer("testusdt");
+    AnalyticsTable analytics;
+    BookViewTable views;
+    synchronizer.setAnalyticsSlot(&analytics, analytics.addSymbol("testusdt"));
+    synchronizer.setViewSlot(&views, views.addSymbol("testusdt"));
+    synchronizer.addAggregationView(10);
+    synchronizer.setDepthIndex(1 << 12);
+    DepthHistory history;
+    synchronizer.setDepthHistory(&history);
+    SubscriptionHandle subscription = synchronizer.subscribe({.topLevels = 20});
+    synchronizer.startOffline(makeSnapshot(snapshotId));
+
+    DepthEvent event;
+    LevelChange change;
+    auto replay = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            {
+                ORDERBOOK_ALLOC_MESSAGE();
+                {
+                    ORDERBOOK_ALLOC_STAGE(PARSE);
+                    synchronizer.parseDepthEvent(frames[i], event);
+                }
+                synchronizer.processDepthEvent(event);
+            }
+            while (subscription->poll(change))
+            {
+            }
+        }
+    };
+
+    // Warm-up grows the reused buffers and fills the node pools to the book's working size
+    replay(0, warmup);
+    AllocationTracker::reset();
+    replay(warmup, warmup + messages);
+    AllocationStats stats = AllocationTracker::snapshot();
+
+    synchronizer.stop();
+    printReport(stats);
+
+    if (!synchronizer.isSynchronized() || synchronizer.getLocalUpdateId() == snapshotId)
+    {
+        std::cerr << "FAIL: replay did not keep the book synchronized" << std::endl;
+        return 1;
+    }
+    if (stats.messagesWithAllocations > 0)
+    {
+        std::cerr << "FAIL: " << stats.messagesWithAllocations << " of " << stats.messages
+                  << " steady-state messages allocated" << std::endl;
+        return 1;
+    }
+    std::cout << "OK: steady-state depth messages allocate nothing" << std::endl;
+    return 0;
+}
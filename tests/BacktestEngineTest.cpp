@@ -0,0 +1,131 @@
+// Deterministic replay of a hand-written journal through BacktestEngine: queue position,
+// partial fills, market orders and resting orders crossed by several levels at once.
+#include "BacktestEngine.h"
+#include "BookJournal.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+namespace
+{
+int failures = 0;
+
+void expectNear(const char *what, double actual, double expected)
+{
+    if (std::abs(actual - expected) > 1e-9)
+    {
+        std::printf("FAIL %s: got %.10g, expected %.10g\n", what, actual, expected);
+        failures++;
+    }
+}
+
+OrderBookData makeBook(long long updateId, std::initializer_list<std::pair<double, double>> bids,
+                       std::initializer_list<std::pair<double, double>> asks)
+{
+    OrderBookData book;
+    BidsMap bidLevels;
+    AsksMap askLevels;
+    for (const auto &[price, quantity] : bids)
+        bidLevels[price] = quantity;
+    for (const auto &[price, quantity] : asks)
+        askLevels[price] = quantity;
+    book.replaceLevels(bidLevels, askLevels, updateId);
+    return book;
+}
+
+void writeJournal(const std::string &directory)
+{
+    BookJournal journal(directory);
+    if (!journal.open())
+    {
+        std::printf("FAIL cannot open journal %s\n", directory.c_str());
+        std::exit(1);
+    }
+
+    journal.appendCheckpoint(1000, makeBook(100, {{99.0, 8.0}, {98.0, 5.0}}, {{101.0, 2.0}, {102.0, 3.0}}));
+
+    // Queue at 99: A joins behind 8, four leave, six more join behind A, then B joins behind 10
+    journal.appendDelta(2000, 101, JournalSide::BID, 99.0, 4.0);
+    journal.appendDelta(2100, 102, JournalSide::BID, 99.0, 10.0);
+    journal.appendDelta(3000, 103, JournalSide::BID, 99.0, 3.0);  // 7 traded: A's 4 ahead, then A fills 2
+    journal.appendDelta(4000, 104, JournalSide::BID, 99.0, 0.0);  // B's last 3 ahead leave
+    journal.appendDelta(4100, 105, JournalSide::BID, 99.0, 2.0);
+    journal.appendDelta(5000, 106, JournalSide::BID, 99.0, 1.0);  // 1 traded through B
+    journal.appendDelta(6000, 107, JournalSide::BID, 98.0, 4.0);  // C and D rest before the resync
+
+    // A resync lands a book whose asks cross two resting buys over several levels
+    journal.appendCheckpoint(7000, makeBook(500, {{99.5, 1.0}}, {{100.0, 1.0}, {100.2, 2.0}, {100.4, 5.0}}));
+    journal.appendDelta(8000, 501, JournalSide::BID, 99.4, 1.0);
+
+    // A cancelled order must not fill again once the asks reach its price
+    journal.appendDelta(9000, 502, JournalSide::ASK, 100.3, 5.0);
+}
+} // namespace
+
+int main()
+{
+    std::string directory = (std::filesystem::temp_directory_path() / "backtest_engine_test").string();
+    std::filesystem::remove_all(directory);
+    writeJournal(directory);
+
+    BookJournalReader reader(directory);
+    if (!reader.open())
+    {
+        std::printf("FAIL cannot read journal %s\n", directory.c_str());
+        return 1;
+    }
+
+    BacktestEngine engine;
+    engine.addOrder({1500, SimSide::BUY, SimOrderType::LIMIT, 99.0, 2.0});   // A
+    engine.addOrder({1500, SimSide::BUY, SimOrderType::MARKET, 0.0, 4.0});   // M
+    engine.addOrder({2500, SimSide::BUY, SimOrderType::LIMIT, 99.0, 2.0});   // B
+    engine.addOrder({5500, SimSide::BUY, SimOrderType::LIMIT, 100.5, 2.0});  // C
+    engine.addOrder({5600, SimSide::BUY, SimOrderType::LIMIT, 100.3, 3.0});  // D
+    BacktestReport report = engine.run(reader);
+
+    const std::vector<SimOrder> &orders = engine.getOrders();
+    if (orders.size() != 5)
+    {
+        std::printf("FAIL expected 5 orders, got %zu\n", orders.size());
+        return 1;
+    }
+    const SimOrder &a = orders[0];
+    const SimOrder &m = orders[1];
+    const SimOrder &b = orders[2];
+    const SimOrder &c = orders[3];
+    const SimOrder &d = orders[4];
+
+    // Queue position: A was ahead of B, so the first trade-through fills A and B waits its turn
+    expectNear("A filled", a.filled, 2.0);
+    expectNear("A notional", a.fillNotional, 198.0);
+    expectNear("A last fill", static_cast<double>(a.lastFillNs), 3000.0);
+
+    // Partial: B's queue drains, then only one unit trades through it
+    expectNear("B filled", b.filled, 1.0);
+    expectNear("B last fill", static_cast<double>(b.lastFillNs), 5000.0);
+
+    // Market order walks 2 @ 101 and 2 @ 102
+    expectNear("M filled", m.filled, 4.0);
+    expectNear("M notional", m.fillNotional, 406.0);
+
+    // Multi-level cross: C takes 1 @ 100.0 and 1 @ 100.2; D shares 100.2 and cannot reach 100.4
+    expectNear("C filled", c.filled, 2.0);
+    expectNear("C notional", c.fillNotional, 200.2);
+    expectNear("D filled", d.filled, 1.0);
+    expectNear("D notional", d.fillNotional, 100.2);
+
+    expectNear("orders filled", static_cast<double>(report.ordersFilled), 3.0);
+    expectNear("orders partial", static_cast<double>(report.ordersPartiallyFilled), 2.0);
+    expectNear("books loaded", static_cast<double>(report.booksLoaded), 2.0);
+
+    std::filesystem::remove_all(directory);
+
+    if (failures > 0)
+    {
+        return 1;
+    }
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,157 @@
+// Randomized check of the depth index against the map walk: two books receive the same levels and
+// updates, one with a DepthIndex and one without, and every liquidity query must agree.
+#include "OrderBookData.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+int failures = 0;
+
+bool near(double actual, double expected)
+{
+    return std::abs(actual - expected) <= 1e-9 * (1.0 + std::abs(expected));
+}
+
+void expectSame(const char *what, const FillEstimate &indexed, const FillEstimate &walked)
+{
+    if (!near(indexed.quantity, walked.quantity) || !near(indexed.notional, walked.notional) ||
+        !near(indexed.averagePrice, walked.averagePrice) || !near(indexed.worstPrice, walked.worstPrice))
+    {
+        std::printf("FAIL %s: index avg %.10g worst %.10g qty %.10g, map avg %.10g worst %.10g qty %.10g\n", what,
+                    indexed.averagePrice, indexed.worstPrice, indexed.quantity, walked.averagePrice,
+                    walked.worstPrice, walked.quantity);
+        failures++;
+    }
+}
+
+void expectSame(const char *what, const DepthSum &indexed, const DepthSum &walked)
+{
+    if (!near(indexed.quantity, walked.quantity) || !near(indexed.notional, walked.notional))
+    {
+        std::printf("FAIL %s: index %.10g / %.10g, map %.10g / %.10g\n", what, indexed.quantity, indexed.notional,
+                    walked.quantity, walked.notional);
+        failures++;
+    }
+}
+
+// Random walk of the touch with level updates around it, so the index re-anchors both ways
+void randomized(double tick, size_t indexTicks, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> quantity(0.001, 5.0);
+    std::uniform_int_distribution<int> offset(0, 400);
+    std::uniform_int_distribution<int> drift(-3, 3);
+    std::bernoulli_distribution remove(0.3);
+
+    OrderBookData indexed;
+    OrderBookData walked;
+    indexed.setTickSize(tick);
+    walked.setTickSize(tick);
+    indexed.setDepthIndex(indexTicks);
+
+    int64_t midTick = std::llround(100.0 / tick);
+    BidsMap bids;
+    AsksMap asks;
+    for (int i = 1; i <= 300; ++i)
+    {
+        bids[static_cast<double>(midTick - offset(rng) - 1) * tick] = quantity(rng);
+        asks[static_cast<double>(midTick + offset(rng) + 1) * tick] = quantity(rng);
+    }
+    indexed.replaceLevels(bids, asks, 1);
+    walked.replaceLevels(bids, asks, 1);
+
+    char what[64];
+    for (int step = 0; step < 20000; ++step)
+    {
+        midTick += drift(rng);
+        bool bid = step % 2 == 0;
+        int64_t levelTick = bid ? midTick - offset(rng) - 1 : midTick + offset(rng) + 1;
+        double price = static_cast<double>(levelTick) * tick;
+        double size = remove(rng) ? 0.0 : quantity(rng);
+
+        // Keep the book uncrossed, as the exchange does
+        if (bid && !walked.getAsks().empty() && price >= walked.getAsks().begin()->first)
+            continue;
+        if (!bid && !walked.getBids().empty() && price <= walked.getBids().begin()->first)
+            continue;
+
+        if (bid)
+        {
+            indexed.setBid(price, size);
+            walked.setBid(price, size);
+        }
+        else
+        {
+            indexed.setAsk(price, size);
+            walked.setAsk(price, size);
+        }
+
+        if (step % 97 == 0)
+        {
+            double target = quantity(rng) * 40.0;
+            double bps = quantity(rng) * 20.0;
+            std::snprintf(what, sizeof(what), "tick %g step %d", tick, step);
+            expectSame(what, indexed.estimateFill(true, target), walked.estimateFill(true, target));
+            expectSame(what, indexed.estimateFill(false, target), walked.estimateFill(false, target));
+            expectSame(what, indexed.depthWithinBps(true, bps), walked.depthWithinBps(true, bps));
+            expectSame(what, indexed.depthWithinBps(false, bps), walked.depthWithinBps(false, bps));
+        }
+    }
+}
+
+// Asks every 0.04 under a 0.1 tick: slots would merge levels, so the index must stand down
+void offGrid()
+{
+    OrderBookData indexed;
+    OrderBookData walked;
+    indexed.setTickSize(0.1);
+    walked.setTickSize(0.1);
+    indexed.setDepthIndex(1024);
+
+    BidsMap bids;
+    AsksMap asks;
+    bids[99.9] = 1.0;
+    for (int i = 0; i < 10; ++i)
+    {
+        asks[100.0 + 0.04 * i] = 1.0;
+    }
+    indexed.replaceLevels(bids, asks, 1);
+    walked.replaceLevels(bids, asks, 1);
+
+    FillEstimate fill = indexed.estimateFill(false, 3.5);
+    expectSame("off grid", fill, walked.estimateFill(false, 3.5));
+    if (!near(fill.worstPrice, 100.12))
+    {
+        std::printf("FAIL off grid worst price %.10g, expected 100.12\n", fill.worstPrice);
+        failures++;
+    }
+
+    // The same when the book starts on the grid and an off-grid level arrives as an update
+    asks.clear();
+    asks[100.0] = 1.0;
+    asks[100.1] = 1.0;
+    asks[100.2] = 1.0;
+    indexed.replaceLevels(bids, asks, 2);
+    walked.replaceLevels(bids, asks, 2);
+    indexed.setAsk(100.04, 1.0);
+    walked.setAsk(100.04, 1.0);
+    expectSame("off grid update", indexed.estimateFill(false, 2.5), walked.estimateFill(false, 2.5));
+}
+} // namespace
+
+int main()
+{
+    randomized(0.01, 256, 1);
+    randomized(0.5, 1024, 2);
+    randomized(0.05, 64, 3);
+    offGrid();
+
+    if (failures > 0)
+    {
+        return 1;
+    }
+    std::printf("OK\n");
+    return 0;
+}